@@ -0,0 +1,69 @@
+/**********************************
+ * FILE NAME: AllocCounter.cpp
+ *
+ * DESCRIPTION: Definition of the debug heap allocation counter
+ **********************************/
+
+#include "AllocCounter.h"
+
+#ifdef DEBUGALLOC
+
+static thread_local unsigned long allocs = 0;
+
+/**
+ * FUNCTION NAME: operator new
+ *
+ * DESCRIPTION: Replaces the global operator new to count allocations
+ */
+void *operator new(size_t size) {
+	allocs++;
+	void *p = malloc(size == 0 ? 1 : size);
+	if (p == NULL) {
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+void operator delete[](void *p) noexcept {
+	free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+// C++14 and later call these for sized deallocations
+void operator delete(void *p, size_t) noexcept {
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+	free(p);
+}
+#endif
+
+void *countedMalloc(size_t size) {
+	allocs++;
+	return malloc(size);
+}
+
+unsigned long allocCount() {
+	return allocs;
+}
+
+#else
+
+void *countedMalloc(size_t size) {
+	return malloc(size);
+}
+
+unsigned long allocCount() {
+	return 0;
+}
+
+#endif
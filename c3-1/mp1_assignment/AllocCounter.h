@@ -0,0 +1,29 @@
+/**********************************
+ * FILE NAME: AllocCounter.h
+ *
+ * DESCRIPTION: Header file of the debug heap allocation counter
+ **********************************/
+
+#ifndef ALLOCCOUNTER_H_
+#define ALLOCCOUNTER_H_
+
+#include "stdincludes.h"
+
+/**
+ * FUNCTION NAME: allocCount
+ *
+ * DESCRIPTION: Number of operator new and countedMalloc calls made by the
+ * 				calling thread so far. Only counted when DEBUGALLOC is defined,
+ * 				always 0 otherwise. The emulated network's malloc'd buffers
+ * 				stand for the wire and are not counted.
+ */
+unsigned long allocCount();
+
+/**
+ * FUNCTION NAME: countedMalloc
+ *
+ * DESCRIPTION: malloc for the node's own buffers, counted like operator new
+ */
+void *countedMalloc(size_t size);
+
+#endif /* ALLOCCOUNTER_H_ */
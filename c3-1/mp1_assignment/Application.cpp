@@ -10,6 +10,9 @@ void handler(int sig) {
 	void *array[10];
 	size_t size;
 
+	// write out the log lines still queued for the writer
+	Log::flushOnCrash();
+
 	// get void*'s for all entries on the stack
 	size = backtrace(array, 10);
 
@@ -25,7 +28,8 @@ void handler(int sig) {
  * DESCRIPTION: main function. Start from here
  **********************************/
 int main(int argc, char *argv[]) {
-	//signal(SIGSEGV, handler);
+	signal(SIGSEGV, handler);
+	signal(SIGABRT, handler);
 	if ( argc != ARGS_COUNT ) {
 		cout<<"Configuration (i.e., *.conf) file File Required"<<endl;
 		return FAILURE;
@@ -51,21 +55,33 @@ Application::Application(char *infile) {
 	par->setparams(infile);
 	log = new Log(par);
 	en = new EmulNet(par);
-	mp1 = (MP1Node **) malloc(par->EN_GPSZ * sizeof(MP1Node *));
+
+	// the nodes first, then the Members, aligned for both
+	size_t nodesSize = par->EN_GPSZ * sizeof(MP1Node);
+	nodesSize = (nodesSize + alignof(Member) - 1) / alignof(Member) * alignof(Member);
+	arena = (char *) malloc(nodesSize + par->EN_GPSZ * sizeof(Member));
+	mp1 = (MP1Node *) arena;
+	members = (Member *) (arena + nodesSize);
+	startTick = (int *) malloc(par->EN_GPSZ * sizeof(int));
+	running.init(par->EN_GPSZ);
 
 	/*
 	 * Init all nodes
 	 */
 	for( i = 0; i < par->EN_GPSZ; i++ ) {
-		Member *memberNode = new Member;
+		Member *memberNode = new (&members[i]) Member;
 		memberNode->inited = false;
-		Address *addressOfMemberNode = new Address();
+		Address addressOfMemberNode;
 		Address joinaddr;
 		joinaddr = getjoinaddr();
-		addressOfMemberNode = (Address *) en->ENinit(addressOfMemberNode, par->PORTNUM);
-		mp1[i] = new MP1Node(memberNode, par, en, log, addressOfMemberNode);
-		log->LOG(&(mp1[i]->getMemberNode()->addr), "APP");
-		delete addressOfMemberNode;
+		en->ENinit(&addressOfMemberNode, par->PORTNUM);
+		new (&mp1[i]) MP1Node(memberNode, par, en, log, &addressOfMemberNode);
+#ifdef COROUTINES
+		mp1[i].setScheduler(&sched);
+#endif
+		// always logged: the first line of dbg.log is written without its address
+		log->LOG(&(mp1[i].getMemberNode()->addr), "APP");
+		startTick[i] = (int)(par->STEP_RATE*i);
 	}
 }
 
@@ -76,9 +92,11 @@ Application::~Application() {
 	delete log;
 	delete en;
 	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
-		delete mp1[i];
+		mp1[i].~MP1Node();
+		members[i].~Member();
 	}
-	free(mp1);
+	free(arena);
+	free(startTick);
 	delete par;
 }
 
@@ -104,11 +122,16 @@ int Application::run()
 	}
 
 	// Clean up
+	LOG_AT(log, LOG_DEBUG, LOG_INFO, &mp1[0].getMemberNode()->addr, "#STATSLOG# messages sent to stopped nodes %d", en->ENundelivered());
 	en->ENcleanup();
 
 	for(i=0;i<=par->EN_GPSZ-1;i++) {
-		 mp1[i]->finishUpThisNode();
+		 mp1[i].finishUpThisNode();
 	}
+#ifdef COROUTINES
+	LOG_AT(log, LOG_DEBUG, LOG_INFO, &mp1[0].getMemberNode()->addr, "#STATSLOG# coroutine resumes %ld frames allocated %ld reused %ld",
+			sched.getResumes(), FramePool::getPooled(), FramePool::getReused());
+#endif
 
 	return SUCCESS;
 }
@@ -121,46 +144,59 @@ int Application::run()
 void Application::mp1Run() {
 	int i;
 
-	// For all the nodes in the system
-	for( i = 0; i <= par->EN_GPSZ-1; i++) {
-
-		/*
-		 * Receive messages from the network and queue them in the membership protocol queue
-		 */
-		if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
-			// Receive messages from the network and queue them
-			mp1[i]->recvLoop();
-		}
+	/*
+	 * Hand last tick's messages from the sender shards to the receiver shards
+	 */
+	en->ENtick();
 
+	/*
+	 * Receive messages from the network and queue them in the membership protocol queue
+	 */
+	for( i = running.next(0); i >= 0; i = running.next(i + 1) ) {
+		mp1[i].recvLoop();
+#ifdef COROUTINES
+		mp1[i].notifyMessages();
+#endif
 	}
 
-	// For all the nodes in the system
-	for( i = par->EN_GPSZ - 1; i >= 0; i-- ) {
-
-		/*
-		 * Introduce nodes into the distributed system
-		 */
-		if( par->getcurrtime() == (int)(par->STEP_RATE*i) ) {
+	/*
+	 * Introduce nodes into the distributed system
+	 *
+	 * Start ticks grow with i, so this tick's starters come after every running
+	 * node, and starting them first keeps the old descending order of the loop.
+	 */
+	for( i = par->EN_GPSZ - 1; i >= 0 && startTick[i] >= par->getcurrtime(); i-- ) {
+		if( startTick[i] == par->getcurrtime() ) {
 			// introduce the ith node into the system at time STEPRATE*i
-			mp1[i]->nodeStart(JOINADDR, par->PORTNUM);
-			cout<<i<<"-th introduced node is assigned with the address: "<<mp1[i]->getMemberNode()->addr.getAddress() << endl;
+			mp1[i].nodeStart(JOINADDR, par->PORTNUM);
+			cout<<i<<"-th introduced node is assigned with the address: "<<mp1[i].getMemberNode()->addr.getAddress() << endl;
 			nodeCount += i;
+			running.set(i);
 		}
+	}
 
-		/*
-		 * Handle all the messages in your queue and send heartbeats
-		 */
-		else if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
-			// handle messages and send heartbeats
-			mp1[i]->nodeLoop();
-			#ifdef DEBUGLOG
-			if( (i == 0) && (par->globaltime % 500 == 0) ) {
-				log->LOG(&mp1[i]->getMemberNode()->addr, "@@time=%d", par->getcurrtime());
-			}
-			#endif
+	/*
+	 * Handle all the messages in your queue and send heartbeats
+	 */
+#ifdef COROUTINES
+	// only the nodes whose messages, timers or PONGs are due are resumed
+	sched.run(par->getcurrtime());
+	if( running.test(0) && startTick[0] != par->getcurrtime() && (par->globaltime % 500 == 0) ) {
+		LOG_AT(log, LOG_DEBUG, LOG_INFO, &mp1[0].getMemberNode()->addr, "@@time=%d", par->getcurrtime());
+	}
+#else
+	for( i = running.prev(par->EN_GPSZ - 1); i >= 0; i = running.prev(i - 1) ) {
+		if( startTick[i] == par->getcurrtime() ) {
+			// started above
+			continue;
+		}
+		// handle messages and send heartbeats
+		mp1[i].nodeLoop();
+		if( (i == 0) && (par->globaltime % 500 == 0) ) {
+			LOG_AT(log, LOG_DEBUG, LOG_INFO, &mp1[i].getMemberNode()->addr, "@@time=%d", par->getcurrtime());
 		}
-
 	}
+#endif
 }
 
 /**
@@ -180,18 +216,14 @@ void Application::fail() {
 
 	if( par->SINGLE_FAILURE && par->getcurrtime() == 100 ) {
 		removed = (rand() % par->EN_GPSZ);
-		#ifdef DEBUGLOG
-		log->LOG(&mp1[removed]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-		#endif
-		mp1[removed]->getMemberNode()->bFailed = true;
+		log->logNodeFail(&mp1[removed].getMemberNode()->addr, false, par->GRACEFUL_LEAVE);
+		stopNode(removed);
 	}
 	else if( par->getcurrtime() == 100 ) {
 		removed = rand() % par->EN_GPSZ/2;
 		for ( i = removed; i < removed + par->EN_GPSZ/2; i++ ) {
-			#ifdef DEBUGLOG
-			log->LOG(&mp1[i]->getMemberNode()->addr, "Node failed at time = %d", par->getcurrtime());
-			#endif
-			mp1[i]->getMemberNode()->bFailed = true;
+			log->logNodeFail(&mp1[i].getMemberNode()->addr, true, par->GRACEFUL_LEAVE);
+			stopNode(i);
 		}
 	}
 
@@ -201,17 +233,48 @@ void Application::fail() {
 
 }
 
+/**
+ * FUNCTION NAME: failNode
+ *
+ * DESCRIPTION: Crash the ith node: it stops receiving and running the protocol
+ */
+void Application::failNode(int i) {
+	mp1[i].getMemberNode()->bFailed = true;
+	running.clear(i);
+}
+
+/**
+ * FUNCTION NAME: leaveNode
+ *
+ * DESCRIPTION: Shut the ith node down gracefully: it announces its departure,
+ * 				then stops like a failed node
+ */
+void Application::leaveNode(int i) {
+	mp1[i].leaveGroup();
+	failNode(i);
+}
+
+/**
+ * FUNCTION NAME: stopNode
+ *
+ * DESCRIPTION: Take the ith node out, crashing it or, with GRACEFUL_LEAVE, letting it leave
+ */
+void Application::stopNode(int i) {
+	if( par->GRACEFUL_LEAVE ) {
+		leaveNode(i);
+	} else {
+		failNode(i);
+	}
+}
+
 /**
  * FUNCTION NAME: getjoinaddr
  *
- * DESCRIPTION: This function returns the address of the coordinator
+ * DESCRIPTION: This function returns the address of the coordinator (the introducer booting the group)
  */
 Address Application::getjoinaddr(void){
 	//trace.funcEntry("Application::getjoinaddr");
-    Address joinaddr;
-    joinaddr.init();
-    *(int *)(&(joinaddr.addr))=1;
-    *(short *)(&(joinaddr.addr[4]))=0;
+    Address joinaddr = par->getIntroducer(0);
     //trace.funcExit("Application::getjoinaddr", SUCCESS);
     return joinaddr;
 }
@@ -14,6 +14,7 @@
 #include "Member.h"
 #include "EmulNet.h"
 #include "Queue.h"
+#include "Bitmap.h"
 
 /**
  * global variables
@@ -38,8 +39,19 @@ private:
 	char JOINADDR[30];
 	EmulNet *en;
     Log *log;
-	MP1Node **mp1;
+	// every node and its Member, placement constructed in one contiguous block
+	char *arena;
+	MP1Node *mp1;
+	Member *members;
 	Params *par;
+	// dense per-tick driver state: the tick each node starts at, and the
+	// nodes that started and did not fail, scanned instead of the nodes
+	int *startTick;
+	Bitmap running;
+#ifdef COROUTINES
+	// resumes the node coroutines instead of calling nodeLoop
+	Scheduler sched;
+#endif
 public:
 	Application(char *);
 	virtual ~Application();
@@ -47,6 +59,9 @@ public:
 	int run();
 	void mp1Run();
 	void fail();
+	void failNode(int i);
+	void leaveNode(int i);
+	void stopNode(int i);
 };
 
 #endif /* _APPLICATION_H__ */
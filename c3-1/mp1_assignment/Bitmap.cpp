@@ -0,0 +1,109 @@
+/**********************************
+ * FILE NAME: Bitmap.cpp
+ *
+ * DESCRIPTION: Definition of Bitmap class
+ **********************************/
+
+#include "Bitmap.h"
+
+/**
+ * FUNCTION NAME: init
+ *
+ * DESCRIPTION: Size the bitmap for entries 0 to n - 1, all clear
+ */
+void Bitmap::init(int n) {
+	this->n = n;
+	words.assign((n + 63) / 64, 0);
+}
+
+/**
+ * FUNCTION NAME: set
+ *
+ * DESCRIPTION: Add entry i
+ */
+void Bitmap::set(int i) {
+	words[i >> 6] |= 1ULL << (i & 63);
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Remove entry i
+ */
+void Bitmap::clear(int i) {
+	words[i >> 6] &= ~(1ULL << (i & 63));
+}
+
+/**
+ * FUNCTION NAME: test
+ *
+ * DESCRIPTION: true if entry i is set
+ */
+bool Bitmap::test(int i) {
+	return (words[i >> 6] >> (i & 63)) & 1;
+}
+
+/**
+ * FUNCTION NAME: next
+ *
+ * DESCRIPTION: Lowest set entry at or above from
+ *
+ * RETURNS:
+ * -1 if there is none
+ */
+int Bitmap::next(int from) {
+	if (from < 0) {
+		from = 0;
+	}
+	if (from >= n) {
+		return -1;
+	}
+	size_t w = from >> 6;
+	unsigned long long bits = words[w] & (~0ULL << (from & 63));
+	while (bits == 0) {
+		if (++w >= words.size()) {
+			return -1;
+		}
+		bits = words[w];
+	}
+	return (int)(w * 64 + __builtin_ctzll(bits));
+}
+
+/**
+ * FUNCTION NAME: prev
+ *
+ * DESCRIPTION: Highest set entry at or below from
+ *
+ * RETURNS:
+ * -1 if there is none
+ */
+int Bitmap::prev(int from) {
+	if (from >= n) {
+		from = n - 1;
+	}
+	if (from < 0) {
+		return -1;
+	}
+	size_t w = from >> 6;
+	unsigned long long bits = words[w] & (~0ULL >> (63 - (from & 63)));
+	while (bits == 0) {
+		if (w-- == 0) {
+			return -1;
+		}
+		bits = words[w];
+	}
+	return (int)(w * 64 + 63 - __builtin_clzll(bits));
+}
+
+/**
+ * FUNCTION NAME: count
+ *
+ * DESCRIPTION: Number of set entries
+ */
+int Bitmap::count() {
+	int c = 0;
+	for (size_t w = 0; w < words.size(); ++w) {
+		c += __builtin_popcountll(words[w]);
+	}
+	return c;
+}
@@ -0,0 +1,35 @@
+/**********************************
+ * FILE NAME: Bitmap.h
+ *
+ * DESCRIPTION: Header file of Bitmap class
+ **********************************/
+
+#ifndef BITMAP_H_
+#define BITMAP_H_
+
+#include "stdincludes.h"
+
+/**
+ * CLASS NAME: Bitmap
+ *
+ * DESCRIPTION: Dense set of small integers, one bit each. next and prev
+ * 				skip whole words of clear bits, so a scan costs one load per
+ * 				64 entries plus one step per set bit.
+ */
+class Bitmap {
+private:
+	vector<unsigned long long> words;
+	int n;
+public:
+	Bitmap(): n(0) {}
+	virtual ~Bitmap() {}
+	void init(int n);
+	void set(int i);
+	void clear(int i);
+	bool test(int i);
+	int next(int from);
+	int prev(int from);
+	int count();
+};
+
+#endif /* BITMAP_H_ */
@@ -6,64 +6,112 @@
 
 #include "EmulNet.h"
 
+/**
+ * Destructor
+ */
+EmulShard::~EmulShard() {
+	freeMessages();
+	free(sent);
+	free(recv);
+	free(deferred);
+	free(trimmed);
+}
+
+/**
+ * FUNCTION NAME: freeMessages
+ *
+ * DESCRIPTION: Free every message still queued in the shard
+ */
+void EmulShard::freeMessages() {
+	for ( int d = 0; d < EN_SHARDS; d++ ) {
+		for ( size_t i = 0; i < outbox[d].size(); i++ ) {
+			free(outbox[d][i]);
+		}
+		outbox[d].clear();
+	}
+	for ( size_t n = 0; n < mailbox.size(); n++ ) {
+		for ( size_t i = 0; i < mailbox[n].size(); i++ ) {
+			free(mailbox[n][i]);
+		}
+		mailbox[n].clear();
+	}
+}
+
+/**
+ * FUNCTION NAME: init
+ *
+ * DESCRIPTION: Give the shard its range of node ids and its drop RNG seed.
+ * 				Every outbox is reserved to the whole send capacity up front, so
+ * 				sends never allocate beyond the message itself.
+ */
+void EmulShard::init(int firstId, int nodes, unsigned int seed, int shards, size_t capacity) {
+	this->firstId = firstId;
+	this->nodes = nodes;
+	// xorshift never leaves 0
+	rng = seed ? seed : 1;
+	for ( int d = 0; d < shards; d++ ) {
+		outbox[d].reserve(capacity);
+	}
+	mailbox.resize(nodes);
+	sent = (int *) calloc((size_t)nodes * MAX_TIME, sizeof(int));
+	recv = (int *) calloc((size_t)nodes * MAX_TIME, sizeof(int));
+	deferred = (int *) calloc((size_t)nodes, sizeof(int));
+	trimmed = (int *) calloc((size_t)nodes, sizeof(int));
+}
+
+/**
+ * FUNCTION NAME: nextRandom
+ *
+ * DESCRIPTION: Next value of the shard's xorshift32 generator, in [0, 100)
+ */
+int EmulShard::nextRandom() {
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+	return (int)(rng % 100);
+}
+
 /**
  * Constructor
  */
 EmulNet::EmulNet(Params *p)
 {
 	//trace.funcEntry("EmulNet::EmulNet");
-	int i,j;
+	int s;
 	par = p;
-	emulnet.setNextId(1);
-	emulnet.settCurrBuffSize(0);
+	nextid = 1;
 	enInited=0;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			sent_msgs[i][j] = 0;
-			recv_msgs[i][j] = 0;
-		}
+	assert(par->EN_GPSZ <= MAX_NODES);
+	shardCount = max(1, min(EN_SHARDS, par->EN_GPSZ));
+	shards = new EmulShard[shardCount];
+	for ( s = 0; s < shardCount; s++ ) {
+		// ids 1..EN_GPSZ split into contiguous ranges, the inverse of shardOf
+		int first = (s * par->EN_GPSZ + shardCount - 1) / shardCount + 1;
+		int last = ((s + 1) * par->EN_GPSZ + shardCount - 1) / shardCount;
+		shards[s].init(first, last - first + 1, (unsigned int)rand(), shardCount, ENBUFFSIZE / shardCount);
 	}
 	//trace.funcExit("EmulNet::EmulNet", SUCCESS);
 }
 
 /**
- * Copy constructor
+ * Destructor
  */
-EmulNet::EmulNet(EmulNet &anotherEmulNet) {
-	int i, j;
-	this->par = anotherEmulNet.par;
-	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
-	}
-	this->emulnet = anotherEmulNet.emulnet;
+EmulNet::~EmulNet() {
+	delete [] shards;
 }
 
 /**
- * Assignment operator overloading
+ * FUNCTION NAME: shardOf
+ *
+ * DESCRIPTION: Shard owning node id, -1 if no node has that id
  */
-EmulNet& EmulNet::operator =(EmulNet &anotherEmulNet) {
-	int i, j;
-	this->par = anotherEmulNet.par;
-	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
+int EmulNet::shardOf(int id) {
+	if ( id < 1 || id > par->EN_GPSZ ) {
+		return -1;
 	}
-	this->emulnet = anotherEmulNet.emulnet;
-	return *this;
+	return (int)((long long)(id - 1) * shardCount / par->EN_GPSZ);
 }
 
-/**
- * Destructor
- */
-EmulNet::~EmulNet() {}
-
 /**
  * FUNCTION NAME: ENinit
  *
@@ -71,48 +119,55 @@ EmulNet::~EmulNet() {}
  */
 void *EmulNet::ENinit(Address *myaddr, short port) {
 	// Initialize data structures for this member
-	*(int *)(myaddr->addr) = emulnet.nextid++;
-    *(short *)(&myaddr->addr[4]) = 0;
+	*myaddr = Address(nextid++, 0);
 	return myaddr;
 }
 
 /**
  * FUNCTION NAME: ENsend
  *
- * DESCRIPTION: EmulNet send function
+ * DESCRIPTION: EmulNet send function. Only the sender's shard is touched.
  *
  * RETURNS:
  * size
  */
 int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
 	en_msg *em;
-	static char temp[2048];
-	int sendmsg = rand() % 100;
+	int src = myaddr->getId();
+	int from = shardOf(src);
+	int to = shardOf(toaddr->getId());
+
+	assert(from >= 0);
+	if ( to < 0 ) {
+		// nobody could ever receive it
+		return 0;
+	}
+
+	EmulShard &shard = shards[from];
+	size_t queued = 0;
+	for ( int d = 0; d < shardCount; d++ ) {
+		queued += shard.outbox[d].size();
+	}
+	int sendmsg = shard.nextRandom();
 
-	if( (emulnet.currbuffsize >= ENBUFFSIZE) || (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE) || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+	if( (queued >= (size_t)(ENBUFFSIZE / shardCount)) || (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE) || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
 		return 0;
 	}
 
 	em = (en_msg *)malloc(sizeof(en_msg) + size);
 	em->size = size;
 
-	memcpy(&(em->from.addr), &(myaddr->addr), sizeof(em->from.addr));
-	memcpy(&(em->to.addr), &(toaddr->addr), sizeof(em->from.addr));
+	em->from = *myaddr;
+	em->to = *toaddr;
 	memcpy(em + 1, data, size);
 
-	emulnet.buff[emulnet.currbuffsize++] = em;
+	shard.outbox[to].push_back(em);
 
-	int src = *(int *)(myaddr->addr);
 	int time = par->getcurrtime();
 
-	assert(src <= MAX_NODES);
 	assert(time < MAX_TIME);
 
-	sent_msgs[src][time]++;
-
-	#ifdef DEBUGLOG
-		sprintf(temp, "Sending 4+%d B msg type %d to %d.%d.%d.%d:%d ", size-4, *(int *)data, toaddr->addr[0], toaddr->addr[1], toaddr->addr[2], toaddr->addr[3], *(short *)&toaddr->addr[4]);
-	#endif
+	shard.sent[(src - shard.firstId) * MAX_TIME + time]++;
 
 	return size;
 }
@@ -133,6 +188,26 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, string data) {
 	return ret;
 }
 
+/**
+ * FUNCTION NAME: ENtick
+ *
+ * DESCRIPTION: Tick boundary exchange: every shard hands the messages it sent
+ * 				during the last tick to the mailboxes of their destinations.
+ * 				Called once per tick, before any node receives.
+ */
+void EmulNet::ENtick() {
+	for ( int d = 0; d < shardCount; d++ ) {
+		EmulShard &dest = shards[d];
+		for ( int s = 0; s < shardCount; s++ ) {
+			vector<en_msg *> &out = shards[s].outbox[d];
+			for ( size_t i = 0; i < out.size(); i++ ) {
+				dest.mailbox[out[i]->to.getId() - dest.firstId].push_back(out[i]);
+			}
+			out.clear();
+		}
+	}
+}
+
 /**
  * FUNCTION NAME: ENrecv
  *
@@ -143,76 +218,130 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, string data) {
  */
 int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue){
 	// times is always assumed to be 1
-	int i;
-	char* tmp;
-	int sz;
-	en_msg *emsg;
+	int dst = myaddr->getId();
+	int s = shardOf(dst);
+	int time = par->getcurrtime();
 
-	for( i = emulnet.currbuffsize - 1; i >= 0; i-- ) {
-		emsg = emulnet.buff[i];
+	if ( s < 0 ) {
+		return 0;
+	}
 
-		if ( 0 == strcmp(emsg->to.addr, myaddr->addr) ) {
-			sz = emsg->size;
-			tmp = (char *) malloc(sz * sizeof(char));
-			memcpy(tmp, (char *)(emsg+1), sz);
+	EmulShard &shard = shards[s];
+	vector<en_msg *> &box = shard.mailbox[dst - shard.firstId];
+	size_t i, kept = 0;
 
-			emulnet.buff[i] = emulnet.buff[emulnet.currbuffsize-1];
-			emulnet.currbuffsize--;
+	assert(time < MAX_TIME);
 
-			(*enq)(queue, (char *)tmp, sz);
+	for( i = 0; i < box.size(); i++ ) {
+		en_msg *emsg = box[i];
 
-			free(emsg);
+		// enq copies what it keeps; a full receiver leaves the message in the network
+		if (!(*enq)(queue, (char *)(emsg+1), emsg->size)) {
+			box[kept++] = emsg;
+			continue;
+		}
 
-			int dst = *(int *)(myaddr->addr);
-			int time = par->getcurrtime();
+		free(emsg);
+		shard.recv[(dst - shard.firstId) * MAX_TIME + time]++;
+	}
+	box.resize(kept);
 
-			assert(dst <= MAX_NODES);
-			assert(time < MAX_TIME);
+	return 0;
+}
 
-			recv_msgs[dst][time]++;
+/**
+ * FUNCTION NAME: ENundelivered
+ *
+ * DESCRIPTION: Messages waiting in the mailboxes. Running nodes empty theirs
+ * 				every tick, so these are the messages sent to stopped nodes.
+ */
+int EmulNet::ENundelivered() {
+	int n = 0;
+	for ( int s = 0; s < shardCount; s++ ) {
+		for ( size_t i = 0; i < shards[s].mailbox.size(); i++ ) {
+			n += (int)shards[s].mailbox[i].size();
 		}
 	}
+	return n;
+}
 
-	return 0;
+/**
+ * FUNCTION NAME: ENdefer
+ *
+ * DESCRIPTION: Count a message the node's send budget held back for a later tick
+ */
+void EmulNet::ENdefer(Address *myaddr) {
+	int src = myaddr->getId();
+	int from = shardOf(src);
+	if ( from >= 0 ) {
+		shards[from].deferred[src - shards[from].firstId]++;
+	}
+}
+
+/**
+ * FUNCTION NAME: ENtrim
+ *
+ * DESCRIPTION: Count a message the node's send budget dropped
+ */
+void EmulNet::ENtrim(Address *myaddr) {
+	int src = myaddr->getId();
+	int from = shardOf(src);
+	if ( from >= 0 ) {
+		shards[from].trimmed[src - shards[from].firstId]++;
+	}
+}
+
+/**
+ * FUNCTION NAME: ENmaxsize
+ *
+ * DESCRIPTION: Largest payload ENsend accepts
+ */
+int EmulNet::ENmaxsize() {
+	return par->MAX_MSG_SIZE - (int)sizeof(en_msg) - 1;
 }
 
 /**
  * FUNCTION NAME: ENcleanup
  *
  * DESCRIPTION: Cleanup the EmulNet. Called exactly once at the end of the program.
+ * 				The per shard counters are merged into msgcount.log.
  */
 int EmulNet::ENcleanup() {
-	emulnet.nextid=0;
+	nextid=0;
 	int i, j;
 	int sent_total, recv_total;
 
 	FILE* file = fopen("msgcount.log", "w+");
 
-	while(emulnet.currbuffsize > 0) {
-		free(emulnet.buff[--emulnet.currbuffsize]);
+	for ( int s = 0; s < shardCount; s++ ) {
+		shards[s].freeMessages();
 	}
 
 	for ( i = 1; i <= par->EN_GPSZ; i++ ) {
+		EmulShard &shard = shards[shardOf(i)];
+		int *sent_msgs = shard.sent + (i - shard.firstId) * MAX_TIME;
+		int *recv_msgs = shard.recv + (i - shard.firstId) * MAX_TIME;
 		fprintf(file, "node %3d ", i);
 		sent_total = 0;
 		recv_total = 0;
 
 		for (j = 0; j < par->getcurrtime(); j++) {
 
-			sent_total += sent_msgs[i][j];
-			recv_total += recv_msgs[i][j];
+			sent_total += sent_msgs[j];
+			recv_total += recv_msgs[j];
 			if (i != 67) {
-				fprintf(file, " (%4d, %4d)", sent_msgs[i][j], recv_msgs[i][j]);
+				fprintf(file, " (%4d, %4d)", sent_msgs[j], recv_msgs[j]);
 				if (j % 10 == 9) {
 					fprintf(file, "\n         ");
 				}
 			}
 			else {
-				fprintf(file, "special %4d %4d %4d\n", j, sent_msgs[i][j], recv_msgs[i][j]);
+				fprintf(file, "special %4d %4d %4d\n", j, sent_msgs[j], recv_msgs[j]);
 			}
 		}
 		fprintf(file, "\n");
-		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n\n", i, sent_total, recv_total);
+		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n", i, sent_total, recv_total);
+		fprintf(file, "node %3d deferred %6u  trimmed %6u\n\n", i, shard.deferred[i - shard.firstId], shard.trimmed[i - shard.firstId]);
 	}
 
 	fclose(file);
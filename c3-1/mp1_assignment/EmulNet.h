@@ -10,6 +10,8 @@
 #define MAX_NODES 1000
 #define MAX_TIME 3600
 #define ENBUFFSIZE 30000
+// workers the network is split into, each sender shard may hold ENBUFFSIZE / EN_SHARDS messages per tick
+#define EN_SHARDS 4
 
 #include "stdincludes.h"
 #include "Params.h"
@@ -30,69 +32,74 @@ typedef struct en_msg {
 }en_msg;
 
 /**
- * Class Name: EM
+ * Class Name: EmulShard
+ *
+ * DESCRIPTION: The part of the emulated network owned by one worker: the
+ * 				messages its nodes sent this tick, by destination shard, the
+ * 				mailboxes of its nodes, its own drop RNG and the message
+ * 				counters of its nodes. Nothing in it is touched by the nodes
+ * 				of another shard during a tick.
  */
-class EM {
+class EmulShard {
 public:
-	int nextid;
-	int currbuffsize;
-	int firsteltindex;
-	en_msg* buff[ENBUFFSIZE];
-	EM() {}
-	EM& operator = (EM &anotherEM) {
-		this->nextid = anotherEM.getNextId();
-		this->currbuffsize = anotherEM.getCurrBuffSize();
-		this->firsteltindex = anotherEM.getFirstEltIndex();
-		int i = this->currbuffsize;
-		while (i > 0) {
-			this->buff[i] = anotherEM.buff[i];
-			i--;
-		}
-		return *this;
-	}
-	int getNextId() {
-		return nextid;
-	}
-	int getCurrBuffSize() {
-		return currbuffsize;
-	}
-	int getFirstEltIndex() {
-		return firsteltindex;
-	}
-	void setNextId(int nextid) {
-		this->nextid = nextid;
-	}
-	void settCurrBuffSize(int currbuffsize) {
-		this->currbuffsize = currbuffsize;
-	}
-	void setFirstEltIndex(int firsteltindex) {
-		this->firsteltindex = firsteltindex;
-	}
-	virtual ~EM() {}
+	// first node id of the shard and number of nodes
+	int firstId;
+	int nodes;
+	// messages sent this tick, by destination shard, moved to the mailboxes at the next tick
+	vector<en_msg *> outbox[EN_SHARDS];
+	// undelivered messages of every node of the shard, by id - firstId
+	vector< vector<en_msg *> > mailbox;
+	// xorshift state of the message drop decisions
+	unsigned int rng;
+	// sent and received messages per node and tick, nodes x MAX_TIME
+	int *sent;
+	int *recv;
+	// messages the send budget of each node deferred and trimmed
+	int *deferred;
+	int *trimmed;
+	// keeps the hot fields of neighbouring shards off a shared cache line
+	char pad[64];
+	EmulShard(): firstId(0), nodes(0), rng(1), sent(NULL), recv(NULL), deferred(NULL), trimmed(NULL) {}
+	virtual ~EmulShard();
+	void init(int firstId, int nodes, unsigned int seed, int shards, size_t capacity);
+	int nextRandom();
+	void freeMessages();
 };
 
 /**
  * CLASS NAME: EmulNet
  *
- * DESCRIPTION: This class defines an emulated network
+ * DESCRIPTION: This class defines an emulated network.
+ * 				Nodes are split into EN_SHARDS contiguous ranges of ids, one
+ * 				per worker. A send only touches the sender's shard; ENtick
+ * 				hands the outboxes to the destination shards at the tick
+ * 				boundary, so messages are received the tick after they are
+ * 				sent, as with the single buffer before.
  */
 class EmulNet
 { 	
 private:
 	Params* par;
-	int sent_msgs[MAX_NODES + 1][MAX_TIME];
-	int recv_msgs[MAX_NODES + 1][MAX_TIME];
+	int nextid;
+	int shardCount;
+	EmulShard *shards;
 	int enInited;
-	EM emulnet;
+	int shardOf(int id);
+	// not copyable, the shards own their messages
+	EmulNet(EmulNet &anotherEmulNet);
+	EmulNet& operator = (EmulNet &anotherEmulNet);
 public:
  	EmulNet(Params *p);
- 	EmulNet(EmulNet &anotherEmulNet);
- 	EmulNet& operator = (EmulNet &anotherEmulNet);
  	virtual ~EmulNet();
 	void *ENinit(Address *myaddr, short port);
 	int ENsend(Address *myaddr, Address *toaddr, string data);
 	int ENsend(Address *myaddr, Address *toaddr, char *data, int size);
 	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue);
+	void ENtick();
+	int ENundelivered();
+	void ENdefer(Address *myaddr);
+	void ENtrim(Address *myaddr);
+	int ENmaxsize();
 	int ENcleanup();
 };
 
@@ -0,0 +1,79 @@
+/**********************************
+ * FILE NAME: EventExport.cpp
+ *
+ * DESCRIPTION: Render an events.bin written with LOG_EVENTS as the dbg.log
+ * 				text Log writes without it.
+ * 				Usage: ./EventExport [events.bin [dbg.log]]
+ **********************************/
+
+#include "EventLog.h"
+#include "Log.h"
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Map the records and print their lines
+ **********************************/
+int main(int argc, char *argv[]) {
+	const char *in = argc > 1 ? argv[1] : EVENTS_LOG;
+	const char *out = argc > 2 ? argv[2] : DBG_LOG;
+
+	int fd = open(in, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(EventRecord)) {
+		fprintf(stderr, "%s: no event log\n", in);
+		return FAILURE;
+	}
+	size_t n = st.st_size / sizeof(EventRecord);
+	const EventRecord *recs = (const EventRecord *) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (recs == MAP_FAILED || recs[0].type != EV_HEADER || recs[0].arg != EVENT_LOG_MAGIC) {
+		fprintf(stderr, "%s: not an event log\n", in);
+		return FAILURE;
+	}
+
+	FILE *fp = fopen(out, "w");
+	if (fp == NULL) {
+		perror(out);
+		return FAILURE;
+	}
+	setvbuf(fp, NULL, _IOFBF, LOG_FILE_BUFFER);
+
+	// the magic number Log puts first
+	int magicNumber = 0;
+	const char *magic = MAGIC_NUMBER;
+	for (size_t i = 0; magic[i] != 0; i++) {
+		magicNumber += (int)magic[i];
+	}
+	fprintf(fp, "%x\n", magicNumber);
+
+	static char line[LOG_LINE_MAX];
+	// Log writes its very first line without the address
+	bool first = true;
+	for (size_t i = 1; i < n && recs[i].type != EV_NONE; ) {
+		const EventRecord *rec = &recs[i++];
+		const char *text = NULL;
+		if (rec->type == EV_TEXT) {
+			size_t records = (rec->arg + sizeof(EventRecord) - 1) / sizeof(EventRecord);
+			if (i + records > n) {
+				break;
+			}
+			text = (const char *)&recs[i];
+			i += records;
+		}
+		Address node(rec->node, rec->nodePort);
+		if (first) {
+			fprintf(fp, "\n [%d] ", rec->tick);
+			first = false;
+		} else {
+			fprintf(fp, "\n %d.%d.%d.%d:%d [%d] ", node.getByte(0), node.getByte(1), node.getByte(2), node.getByte(3),
+					node.getPort(), rec->tick);
+		}
+		int len = EventLog::format(rec, text, line, sizeof(line));
+		fwrite(line, 1, min(len, (int)sizeof(line) - 1), fp);
+	}
+
+	fclose(fp);
+	munmap((void *)recs, st.st_size);
+	close(fd);
+	return SUCCESS;
+}
@@ -0,0 +1,148 @@
+/**********************************
+ * FILE NAME: EventLog.cpp
+ *
+ * DESCRIPTION: Definition of EventLog class
+ **********************************/
+
+#include "EventLog.h"
+
+/**
+ * Destructor
+ */
+EventLog::~EventLog() {
+	close();
+}
+
+/**
+ * FUNCTION NAME: open
+ *
+ * DESCRIPTION: Create the file and write its header record
+ *
+ * RETURNS:
+ * false if the file can not be created
+ */
+bool EventLog::open(const char *path) {
+	fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	remap();
+	EventRecord header;
+	memset(&header, 0, sizeof(header));
+	header.type = EV_HEADER;
+	header.arg = EVENT_LOG_MAGIC;
+	append(&header);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: remap
+ *
+ * DESCRIPTION: Grow the file by a chunk and map the chunk after the current window
+ */
+void EventLog::remap() {
+	size_t bytes = EVENT_LOG_CHUNK * sizeof(EventRecord);
+	if (window != NULL) {
+		munmap(window, bytes);
+		base += used;
+	}
+	used = 0;
+	window = NULL;
+	if (ftruncate(fd, (off_t)((base + EVENT_LOG_CHUNK) * sizeof(EventRecord))) != 0) {
+		return;
+	}
+	void *m = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, (off_t)(base * sizeof(EventRecord)));
+	if (m != MAP_FAILED) {
+		window = (EventRecord *) m;
+	}
+}
+
+/**
+ * FUNCTION NAME: append
+ *
+ * DESCRIPTION: Append one record, dropped if the file could not grow
+ */
+void EventLog::append(const EventRecord *rec) {
+	if (window != NULL && used == EVENT_LOG_CHUNK) {
+		remap();
+	}
+	if (window == NULL) {
+		return;
+	}
+	window[used++] = *rec;
+}
+
+/**
+ * FUNCTION NAME: appendText
+ *
+ * DESCRIPTION: Append a free text line, its bytes padded into the records after it
+ */
+void EventLog::appendText(int tick, Address *node, const char *text, size_t len) {
+	EventRecord rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.tick = (unsigned short)tick;
+	rec.node = (unsigned short)node->getId();
+	rec.nodePort = node->getPort();
+	rec.type = EV_TEXT;
+	rec.arg = (int)len;
+	append(&rec);
+	for (size_t i = 0; i < len; i += sizeof(rec)) {
+		memset(&rec, 0, sizeof(rec));
+		memcpy(&rec, text + i, min(sizeof(rec), len - i));
+		append(&rec);
+	}
+}
+
+/**
+ * FUNCTION NAME: close
+ *
+ * DESCRIPTION: Unmap and trim the file to the records written
+ */
+void EventLog::close() {
+	if (fd < 0) {
+		return;
+	}
+	if (window != NULL) {
+		munmap(window, EVENT_LOG_CHUNK * sizeof(EventRecord));
+		window = NULL;
+	}
+	// if it can not be trimmed, the zero records past the end read as EV_NONE
+	if (ftruncate(fd, (off_t)((base + used) * sizeof(EventRecord))) != 0) {
+		perror(EVENTS_LOG);
+	}
+	::close(fd);
+	fd = -1;
+}
+
+/**
+ * FUNCTION NAME: format
+ *
+ * DESCRIPTION: Text of the dbg.log line of a record, without the address and
+ * 				tick prefix. text holds the bytes of an EV_TEXT record.
+ *
+ * RETURNS:
+ * length of the text, as snprintf
+ */
+int EventLog::format(const EventRecord *rec, const char *text, char *out, size_t max) {
+	Address subject(rec->subject, rec->subjectPort);
+	switch (rec->type) {
+	case EV_TEXT:
+		return snprintf(out, max, "%.*s", rec->arg, text);
+	case EV_JOINED:
+	case EV_REMOVED:
+		return snprintf(out, max, "Node %d.%d.%d.%d:%d %s at time %d", subject.getByte(0), subject.getByte(1),
+				subject.getByte(2), subject.getByte(3), subject.getPort(), rec->type == EV_JOINED ? "joined" : "removed",
+				rec->tick);
+	case EV_PING:
+	case EV_PONG:
+		return snprintf(out, max, "%s received from node %d:%d, %c%d", rec->type == EV_PING ? "PING" : "PONG",
+				subject.getId(), subject.getPort(), rec->status, rec->arg);
+	case EV_FAILED:
+		return snprintf(out, max, "Node failed at time%s%d%s", rec->arg & EV_FAILED_SPACED ? " = " : "=", rec->tick,
+				rec->arg & EV_FAILED_LEAVING ? " by leaving" : "");
+	case EV_SUSPECTED:
+		return snprintf(out, max, "Node %d:%d suspected", subject.getId(), subject.getPort());
+	default:
+		return snprintf(out, max, "unknown event %d", rec->type);
+	}
+}
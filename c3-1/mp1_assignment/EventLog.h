@@ -0,0 +1,96 @@
+/**********************************
+ * FILE NAME: EventLog.h
+ *
+ * DESCRIPTION: Header file of EventLog class
+ **********************************/
+
+#ifndef EVENTLOG_H_
+#define EVENTLOG_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+
+/*
+ * Macros
+ */
+#define EVENTS_LOG "events.bin"
+// "EVL1", the arg of the header record
+#define EVENT_LOG_MAGIC 0x314c5645
+// records mapped at a time, the file grows by as many
+#define EVENT_LOG_CHUNK (1 << 16)
+
+/**
+ * ENUM NAME: EventType
+ *
+ * DESCRIPTION: Kind of an event record. 0 marks the unwritten end of the file.
+ */
+enum EventType {
+	EV_NONE,
+	EV_HEADER,
+	// free text, arg bytes of it in the records that follow
+	EV_TEXT,
+	EV_JOINED,
+	EV_REMOVED,
+	// status and arg: status and id of the last member piggybacked on it
+	EV_PING,
+	EV_PONG,
+	// arg: EV_FAILED_SPACED and EV_FAILED_LEAVING
+	EV_FAILED,
+	EV_SUSPECTED
+};
+
+// "time = t" as the multi failure scenario logs it, rather than "time=t"
+#define EV_FAILED_SPACED 1
+// the node left gracefully
+#define EV_FAILED_LEAVING 2
+
+/**
+ * STRUCT NAME: EventRecord
+ *
+ * DESCRIPTION: One dbg.log event in 16 bytes. Ticks and node ids fit 16 bits
+ * 				under MAX_TIME and MAX_NODES.
+ */
+typedef struct EventRecord {
+	unsigned short tick;
+	unsigned short node;
+	short nodePort;
+	unsigned short subject;
+	short subjectPort;
+	unsigned char type;
+	char status;
+	int arg;
+} EventRecord;
+
+static_assert(sizeof(EventRecord) == 16, "EventRecord must stay 16 bytes");
+
+/**
+ * CLASS NAME: EventLog
+ *
+ * DESCRIPTION: Append-only file of EventRecords, written through a shared
+ * 				mapping of EVENT_LOG_CHUNK records at a time. Appending is a
+ * 				copy into the page cache, so the records survive a crash of
+ * 				the process; close() trims the file to the records written.
+ * 				format() renders a record as the text of its dbg.log line,
+ * 				for Log's text mode and for EventExport alike.
+ */
+class EventLog {
+private:
+	int fd;
+	EventRecord *window;
+	// records before the window, and used in it
+	size_t base;
+	size_t used;
+	void remap();
+	EventLog(const EventLog &);
+	EventLog &operator =(const EventLog &);
+public:
+	EventLog(): fd(-1), window(NULL), base(0), used(0) {}
+	virtual ~EventLog();
+	bool open(const char *path);
+	void append(const EventRecord *rec);
+	void appendText(int tick, Address *node, const char *text, size_t len);
+	void close();
+	static int format(const EventRecord *rec, const char *text, char *out, size_t max);
+};
+
+#endif /* EVENTLOG_H_ */
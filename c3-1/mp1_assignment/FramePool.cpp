@@ -0,0 +1,65 @@
+/**********************************
+ * FILE NAME: FramePool.cpp
+ *
+ * DESCRIPTION: Definition of FramePool class
+ **********************************/
+
+#include "FramePool.h"
+
+thread_local FramePool::FreeFrame *FramePool::freeLists[FRAME_POOL_MAX / FRAME_CLASS];
+thread_local long FramePool::pooled = 0;
+thread_local long FramePool::reused = 0;
+
+/**
+ * FUNCTION NAME: allocate
+ *
+ * DESCRIPTION: Take a frame of at least size bytes from its free list, or from malloc
+ */
+void *FramePool::allocate(size_t size) {
+	size_t c = (size + FRAME_CLASS - 1) / FRAME_CLASS;
+	if (c == 0 || c > FRAME_POOL_MAX / FRAME_CLASS) {
+		return countedMalloc(size);
+	}
+	FreeFrame *frame = freeLists[c - 1];
+	if (frame != NULL) {
+		freeLists[c - 1] = frame->next;
+		reused++;
+		return frame;
+	}
+	pooled++;
+	return countedMalloc(c * FRAME_CLASS);
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Put a frame back on the free list of its size class
+ */
+void FramePool::release(void *frame, size_t size) {
+	size_t c = (size + FRAME_CLASS - 1) / FRAME_CLASS;
+	if (c == 0 || c > FRAME_POOL_MAX / FRAME_CLASS) {
+		free(frame);
+		return;
+	}
+	FreeFrame *f = (FreeFrame *)frame;
+	f->next = freeLists[c - 1];
+	freeLists[c - 1] = f;
+}
+
+/**
+ * FUNCTION NAME: getPooled
+ *
+ * DESCRIPTION: Number of frames the pool had to malloc
+ */
+long FramePool::getPooled() {
+	return pooled;
+}
+
+/**
+ * FUNCTION NAME: getReused
+ *
+ * DESCRIPTION: Number of frames served from a free list
+ */
+long FramePool::getReused() {
+	return reused;
+}
@@ -0,0 +1,44 @@
+/**********************************
+ * FILE NAME: FramePool.h
+ *
+ * DESCRIPTION: Header file of FramePool class
+ **********************************/
+
+#ifndef FRAMEPOOL_H_
+#define FRAMEPOOL_H_
+
+#include "stdincludes.h"
+#include "AllocCounter.h"
+
+/*
+ * Macros
+ */
+// frame sizes are rounded up to FRAME_CLASS bytes, frames above FRAME_POOL_MAX bytes are not pooled
+#define FRAME_CLASS 64
+#define FRAME_POOL_MAX 2048
+
+/**
+ * CLASS NAME: FramePool
+ *
+ * DESCRIPTION: Free lists of coroutine frames by size class. A released
+ * 				frame is reused by the next coroutine of the same class, so
+ * 				coroutines started every tick, like probes, stop allocating
+ * 				once the pool has warmed up. Per thread, nothing is shared.
+ */
+class FramePool {
+private:
+	// a free frame holds the link to the next one
+	struct FreeFrame {
+		FreeFrame *next;
+	};
+	static thread_local FreeFrame *freeLists[FRAME_POOL_MAX / FRAME_CLASS];
+	static thread_local long pooled;
+	static thread_local long reused;
+public:
+	static void *allocate(size_t size);
+	static void release(void *frame, size_t size);
+	static long getPooled();
+	static long getReused();
+};
+
+#endif /* FRAMEPOOL_H_ */
@@ -0,0 +1,196 @@
+/**********************************
+ * FILE NAME: GossipController.cpp
+ *
+ * DESCRIPTION: Definition of GossipController class
+ **********************************/
+
+#include "GossipController.h"
+
+/**
+ * FUNCTION NAME: setGroupSize
+ *
+ * DESCRIPTION: Members this node currently knows of, the estimate of N
+ */
+void GossipController::setGroupSize(int n) {
+	groupSize = max(1, n);
+}
+
+/**
+ * FUNCTION NAME: ackReceived
+ *
+ * DESCRIPTION: A probe was answered
+ */
+void GossipController::ackReceived() {
+	ackLoss *= 1 - GOSSIP_LOSS_ALPHA;
+}
+
+/**
+ * FUNCTION NAME: ackMissed
+ *
+ * DESCRIPTION: A probe timed out
+ */
+void GossipController::ackMissed() {
+	ackLoss = ackLoss * (1 - GOSSIP_LOSS_ALPHA) + GOSSIP_LOSS_ALPHA;
+}
+
+/**
+ * FUNCTION NAME: pingSent
+ *
+ * DESCRIPTION: Size of the PING just sent, its PONG is assumed as large
+ */
+void GossipController::pingSent(size_t bytes) {
+	pingBytes += ((double)bytes - pingBytes) * GOSSIP_LOSS_ALPHA;
+}
+
+/**
+ * FUNCTION NAME: roundDue
+ *
+ * DESCRIPTION: Called once per tick. Starts a round every interval ticks,
+ * 				choosing fanout and interval anew at its start.
+ *
+ * RETURNS:
+ * true if fanout PINGs are to be sent this tick
+ */
+bool GossipController::roundDue() {
+	if (++sinceRound < interval) {
+		return false;
+	}
+	sinceRound = 0;
+	choose();
+	return true;
+}
+
+/**
+ * FUNCTION NAME: takeChanged
+ *
+ * DESCRIPTION: true once after fanout or interval changed
+ */
+bool GossipController::takeChanged() {
+	bool was = changed;
+	changed = false;
+	return was;
+}
+
+/**
+ * FUNCTION NAME: roundsFor
+ *
+ * DESCRIPTION: Rounds a fanout takes to reach the group at the measured loss
+ */
+double GossipController::roundsFor(int f) {
+	double n = max(2, groupSize);
+	// per message delivery, a probe is answered with q * q
+	double q = max(0.05, sqrt(1 - ackLoss));
+	double spread = f * q;
+	return log(n) / log(1 + spread) + log(n) / spread;
+}
+
+/**
+ * FUNCTION NAME: bytesFor
+ *
+ * DESCRIPTION: Bytes per tick a node spends on its PINGs and on as many PONGs
+ */
+double GossipController::bytesFor(int f, int i) {
+	return 2 * f * pingBytes / i;
+}
+
+/**
+ * FUNCTION NAME: choose
+ *
+ * DESCRIPTION: Pick the fanout and interval for the next round
+ */
+void GossipController::choose() {
+	int bestF = 1, bestI = GOSSIP_INTERVAL_MAX;
+	bool bestInTime = false;
+	double bestBytes = 0, bestTime = 0;
+	bool found = false;
+	for (int f = 1; f <= GOSSIP_FANOUT_MAX; ++f) {
+		double rounds = ceil(roundsFor(f));
+		for (int i = 1; i <= GOSSIP_INTERVAL_MAX; ++i) {
+			double bytes = bytesFor(f, i);
+			double time = rounds * i;
+			bool inTime = time <= GOSSIP_CONVERGENCE_TICKS;
+			if (bytes > GOSSIP_BYTES_BUDGET) {
+				continue;
+			}
+			bool better;
+			if (!found) {
+				better = true;
+			} else if (inTime != bestInTime) {
+				better = inTime;
+			} else if (inTime) {
+				// in time: the cheapest, then the fastest
+				better = bytes < bestBytes || (bytes == bestBytes && time < bestTime);
+			} else {
+				// too slow anyway: the fastest, then the cheapest
+				better = time < bestTime || (time == bestTime && bytes < bestBytes);
+			}
+			if (better) {
+				found = true;
+				bestF = f;
+				bestI = i;
+				bestInTime = inTime;
+				bestBytes = bytes;
+				bestTime = time;
+			}
+		}
+	}
+	if (bestF != fanout || bestI != interval) {
+		fanout = bestF;
+		interval = bestI;
+		changed = true;
+	}
+}
+
+/**
+ * FUNCTION NAME: getFanout
+ *
+ * DESCRIPTION: Members to PING per round
+ */
+int GossipController::getFanout() {
+	return fanout;
+}
+
+/**
+ * FUNCTION NAME: getInterval
+ *
+ * DESCRIPTION: Ticks between rounds
+ */
+int GossipController::getInterval() {
+	return interval;
+}
+
+/**
+ * FUNCTION NAME: getGroupSize
+ *
+ * DESCRIPTION: Current estimate of N
+ */
+int GossipController::getGroupSize() {
+	return groupSize;
+}
+
+/**
+ * FUNCTION NAME: getAckLoss
+ *
+ * DESCRIPTION: Average fraction of probes not answered
+ */
+double GossipController::getAckLoss() {
+	return ackLoss;
+}
+
+/**
+ * FUNCTION NAME: getConvergence
+ *
+ * DESCRIPTION: Expected ticks for an update to reach the group with the current choice
+ */
+double GossipController::getConvergence() {
+	return ceil(roundsFor(fanout)) * interval;
+}
+
+/**
+ * FUNCTION NAME: getBytesRate
+ *
+ * DESCRIPTION: Expected PING and PONG bytes per tick with the current choice
+ */
+double GossipController::getBytesRate() {
+	return bytesFor(fanout, interval);
+}
@@ -0,0 +1,70 @@
+/**********************************
+ * FILE NAME: GossipController.h
+ *
+ * DESCRIPTION: Header file of GossipController class
+ **********************************/
+
+#ifndef GOSSIPCONTROLLER_H_
+#define GOSSIPCONTROLLER_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// ticks an update should take to reach the whole group
+#define GOSSIP_CONVERGENCE_TICKS 15
+// bytes a node may spend on PINGs and their PONGs per tick
+#define GOSSIP_BYTES_BUDGET 200
+// bounds of the chosen values
+#define GOSSIP_FANOUT_MAX 4
+#define GOSSIP_INTERVAL_MAX 4
+// weight of the latest probe in the ack loss average
+#define GOSSIP_LOSS_ALPHA 0.05
+// PING size assumed before the first one is sent
+#define GOSSIP_PING_BYTES 20
+
+/**
+ * CLASS NAME: GossipController
+ *
+ * DESCRIPTION: Picks how many members to PING per round (fanout) and how many
+ * 				ticks apart the rounds are (interval). An epidemic with fanout f
+ * 				and per message delivery q reaches N members in about
+ * 				ln N / ln(1 + f q) + ln N / (f q) rounds. The cheapest pair that
+ * 				stays within GOSSIP_BYTES_BUDGET and converges within
+ * 				GOSSIP_CONVERGENCE_TICKS wins; if none converges in time, the
+ * 				fastest pair within the budget. q comes from the measured ack
+ * 				loss: a probe needs both its PING and its PONG delivered.
+ */
+class GossipController {
+private:
+	int groupSize;
+	double ackLoss;
+	double pingBytes;
+	int fanout;
+	int interval;
+	// ticks since the last round
+	int sinceRound;
+	bool changed;
+	double roundsFor(int f);
+	double bytesFor(int f, int i);
+	void choose();
+public:
+	GossipController(): groupSize(1), ackLoss(0), pingBytes(GOSSIP_PING_BYTES), fanout(1), interval(1),
+			sinceRound(0), changed(false) {}
+	virtual ~GossipController() {}
+	void setGroupSize(int n);
+	void ackReceived();
+	void ackMissed();
+	void pingSent(size_t bytes);
+	bool roundDue();
+	bool takeChanged();
+	int getFanout();
+	int getInterval();
+	int getGroupSize();
+	double getAckLoss();
+	double getConvergence();
+	double getBytesRate();
+};
+
+#endif /* GOSSIPCONTROLLER_H_ */
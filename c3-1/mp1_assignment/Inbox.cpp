@@ -0,0 +1,185 @@
+/**********************************
+ * FILE NAME: Inbox.cpp
+ *
+ * DESCRIPTION: Definition of Inbox class
+ **********************************/
+
+#include "Inbox.h"
+
+// released messages of INBOX_POOL_PAYLOAD bytes, linked through next
+static thread_local InboxMsg *freeMsgs = NULL;
+static thread_local long pooledMsgs = 0;
+
+/**
+ * FUNCTION NAME: create
+ *
+ * DESCRIPTION: Allocate a message with a copy of the payload
+ */
+InboxMsg *InboxMsg::create(const char *data, int size) {
+	InboxMsg *msg;
+	if (size <= INBOX_POOL_PAYLOAD && freeMsgs != NULL) {
+		msg = freeMsgs;
+		freeMsgs = msg->next.load(memory_order_relaxed);
+	} else if (size <= INBOX_POOL_PAYLOAD) {
+		msg = (InboxMsg *)countedMalloc(sizeof(InboxMsg) + INBOX_POOL_PAYLOAD);
+		pooledMsgs++;
+	} else {
+		msg = (InboxMsg *)countedMalloc(sizeof(InboxMsg) + size);
+	}
+	new (&msg->next) atomic<InboxMsg *>(NULL);
+	msg->size = size;
+	memcpy(msg->data(), data, size);
+	return msg;
+}
+
+/**
+ * FUNCTION NAME: destroy
+ *
+ * DESCRIPTION: Free a message popped from an inbox
+ */
+void InboxMsg::destroy(InboxMsg *msg) {
+	if (msg->size <= INBOX_POOL_PAYLOAD) {
+		msg->next.store(freeMsgs, memory_order_relaxed);
+		freeMsgs = msg;
+		return;
+	}
+	free(msg);
+}
+
+/**
+ * FUNCTION NAME: getPooled
+ *
+ * DESCRIPTION: Messages the calling thread's free list had to malloc
+ */
+long InboxMsg::getPooled() {
+	return pooledMsgs;
+}
+
+/**
+ * Constructor
+ */
+Inbox::Inbox(): head(&stub), tail(&stub), count(0), refused(0) {
+	stub.next.store(NULL, memory_order_relaxed);
+	stub.size = 0;
+}
+
+/**
+ * Destructor
+ */
+Inbox::~Inbox() {
+	InboxMsg *msg;
+	while ((msg = pop()) != NULL) {
+		InboxMsg::destroy(msg);
+	}
+}
+
+/**
+ * FUNCTION NAME: push
+ *
+ * DESCRIPTION: Append a message. Safe to call from any number of threads.
+ *
+ * RETURNS:
+ * false if the inbox is full; the caller keeps the message
+ */
+bool Inbox::push(InboxMsg *msg) {
+	if (count.fetch_add(1, memory_order_acq_rel) >= INBOX_CAPACITY) {
+		count.fetch_sub(1, memory_order_acq_rel);
+		refused.fetch_add(1, memory_order_relaxed);
+		return false;
+	}
+	link(msg);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: link
+ *
+ * DESCRIPTION: Swap a message in as the new head and link the previous head to it.
+ * 				Between the two steps the consumer sees the queue end at the previous head.
+ */
+void Inbox::link(InboxMsg *msg) {
+	msg->next.store(NULL, memory_order_relaxed);
+	InboxMsg *prev = head.exchange(msg, memory_order_acq_rel);
+	prev->next.store(msg, memory_order_release);
+}
+
+/**
+ * FUNCTION NAME: pop
+ *
+ * DESCRIPTION: Take the oldest message. Consumer thread only.
+ *
+ * RETURNS:
+ * NULL if the inbox is empty or the next message is still being linked
+ */
+InboxMsg *Inbox::pop() {
+	InboxMsg *t = tail;
+	InboxMsg *next = t->next.load(memory_order_acquire);
+	if (t == &stub) {
+		if (next == NULL) {
+			return NULL;
+		}
+		tail = next;
+		t = next;
+		next = next->next.load(memory_order_acquire);
+	}
+	if (next != NULL) {
+		tail = next;
+		return t;
+	}
+	if (t != head.load(memory_order_acquire)) {
+		return NULL;
+	}
+	// t is the last message: put the stub behind it so t can be unlinked
+	link(&stub);
+	next = t->next.load(memory_order_acquire);
+	if (next != NULL) {
+		tail = next;
+		return t;
+	}
+	return NULL;
+}
+
+/**
+ * FUNCTION NAME: popBatch
+ *
+ * DESCRIPTION: Take up to max messages in arrival order. Consumer thread only.
+ *
+ * RETURNS:
+ * number of messages taken
+ */
+size_t Inbox::popBatch(InboxMsg **out, size_t max) {
+	size_t n = 0;
+	InboxMsg *msg;
+	while (n < max && (msg = pop()) != NULL) {
+		out[n++] = msg;
+	}
+	count.fetch_sub((int)n, memory_order_acq_rel);
+	return n;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Number of queued messages, approximate while producers are pushing
+ */
+int Inbox::size() {
+	return count.load(memory_order_acquire);
+}
+
+/**
+ * FUNCTION NAME: full
+ *
+ * DESCRIPTION: true if pushes are being refused
+ */
+bool Inbox::full() {
+	return size() >= INBOX_CAPACITY;
+}
+
+/**
+ * FUNCTION NAME: getRefused
+ *
+ * DESCRIPTION: Number of pushes refused because the inbox was full
+ */
+long Inbox::getRefused() {
+	return refused.load(memory_order_relaxed);
+}
@@ -0,0 +1,69 @@
+/**********************************
+ * FILE NAME: Inbox.h
+ *
+ * DESCRIPTION: Header file of Inbox class
+ **********************************/
+
+#ifndef INBOX_H_
+#define INBOX_H_
+
+#include "stdincludes.h"
+#include "AllocCounter.h"
+
+/*
+ * Macros
+ */
+// messages an inbox holds before refusing more
+#define INBOX_CAPACITY 4096
+// payload bytes of a pooled message, larger ones are malloc'd and freed each time
+#define INBOX_POOL_PAYLOAD 256
+
+/**
+ * STRUCT NAME: InboxMsg
+ *
+ * DESCRIPTION: A received message, allocated together with its link so that
+ * 				queueing it allocates nothing. The payload follows the struct.
+ * 				Messages up to INBOX_POOL_PAYLOAD bytes come from a per thread
+ * 				free list, so steady PING and PONG traffic reuses them.
+ */
+typedef struct InboxMsg {
+	atomic<InboxMsg *> next;
+	int size;
+	char *data() { return (char *)(this + 1); }
+	static InboxMsg *create(const char *data, int size);
+	static void destroy(InboxMsg *msg);
+	static long getPooled();
+} InboxMsg;
+
+/**
+ * CLASS NAME: Inbox
+ *
+ * DESCRIPTION: Bounded, intrusive, lock-free multi-producer single-consumer queue.
+ * 				Any thread may push; only the node's own thread pops. Producers
+ * 				swap themselves in at the head with one atomic exchange, the
+ * 				consumer walks the links from the tail (Vyukov's MPSC queue). A
+ * 				slot counter bounds it: a full inbox refuses the push, and the
+ * 				producer keeps the message until the node has caught up.
+ */
+class Inbox {
+private:
+	atomic<InboxMsg *> head;
+	InboxMsg *tail;
+	InboxMsg stub;
+	atomic<int> count;
+	atomic<long> refused;
+	void link(InboxMsg *msg);
+	InboxMsg *pop();
+	Inbox(const Inbox &);
+	Inbox &operator =(const Inbox &);
+public:
+	Inbox();
+	virtual ~Inbox();
+	bool push(InboxMsg *msg);
+	size_t popBatch(InboxMsg **out, size_t max);
+	int size();
+	bool full();
+	long getRefused();
+};
+
+#endif /* INBOX_H_ */
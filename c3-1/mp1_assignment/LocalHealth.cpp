@@ -0,0 +1,61 @@
+/**********************************
+ * FILE NAME: LocalHealth.cpp
+ *
+ * DESCRIPTION: Definition of LocalHealth class
+ **********************************/
+
+#include "LocalHealth.h"
+
+/**
+ * FUNCTION NAME: probeAcked
+ *
+ * DESCRIPTION: A probe was answered in time
+ */
+void LocalHealth::probeAcked() {
+	score = max(0, score - 1);
+}
+
+/**
+ * FUNCTION NAME: probeMissed
+ *
+ * DESCRIPTION: A probe timed out
+ */
+void LocalHealth::probeMissed() {
+	score = min(LHM_MAX, score + 1);
+}
+
+/**
+ * FUNCTION NAME: refuted
+ *
+ * DESCRIPTION: This node had to refute a suspicion about itself
+ */
+void LocalHealth::refuted() {
+	score = min(LHM_MAX, score + 1);
+}
+
+/**
+ * FUNCTION NAME: setQueueDepth
+ *
+ * DESCRIPTION: Messages waiting when the node got to its queue this tick
+ */
+void LocalHealth::setQueueDepth(int depth) {
+	queueDepth = depth;
+}
+
+/**
+ * FUNCTION NAME: getScore
+ *
+ * DESCRIPTION: Current score, including the queue backlog
+ */
+int LocalHealth::getScore() {
+	return min(LHM_MAX, score + queueDepth / LHM_QUEUE_STEP);
+}
+
+/**
+ * FUNCTION NAME: scale
+ *
+ * DESCRIPTION: Stretch a timeout by the current score
+ */
+int LocalHealth::scale(int timeout) {
+	return timeout * (getScore() + 1);
+}
@@ -0,0 +1,43 @@
+/**********************************
+ * FILE NAME: LocalHealth.h
+ *
+ * DESCRIPTION: Header file of LocalHealth class
+ **********************************/
+
+#ifndef LOCALHEALTH_H_
+#define LOCALHEALTH_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// upper bound of the health score
+#define LHM_MAX 8
+// queued messages per extra point of the score
+#define LHM_QUEUE_STEP 16
+
+/**
+ * CLASS NAME: LocalHealth
+ *
+ * DESCRIPTION: Lifeguard local health multiplier.
+ * 				A node that misses acks or falls behind on its queue is more
+ * 				likely slow itself than surrounded by failed peers, so its
+ * 				score grows and stretches its own timeouts. 0 is healthy.
+ */
+class LocalHealth {
+private:
+	int score;
+	int queueDepth;
+public:
+	LocalHealth(): score(0), queueDepth(0) {}
+	virtual ~LocalHealth() {}
+	void probeAcked();
+	void probeMissed();
+	void refuted();
+	void setQueueDepth(int depth);
+	int getScore();
+	int scale(int timeout);
+};
+
+#endif /* LOCALHEALTH_H_ */
@@ -6,12 +6,22 @@
 
 #include "Log.h"
 
+FILE *Log::files[LOG_RING_FILES] = {NULL, NULL};
+int Log::fds[LOG_RING_FILES] = {-1, -1};
+LogRing *Log::ring = NULL;
+thread Log::writer;
+atomic<bool> Log::stopping(false);
+EventLog *Log::events = NULL;
+
 /**
  * Constructor
  */
 Log::Log(Params *p) {
 	par = p;
 	firstTime = false;
+	for (int c = 0; c < LOG_CATEGORIES; c++) {
+		setLevel(c, par->LOG_LEVEL);
+	}
 }
 
 /**
@@ -20,6 +30,7 @@ Log::Log(Params *p) {
 Log::Log(const Log &anotherLog) {
 	this->par = anotherLog.par;
 	this->firstTime = anotherLog.firstTime;
+	memcpy(this->levels, anotherLog.levels, sizeof(levels));
 }
 
 /**
@@ -28,6 +39,7 @@ Log::Log(const Log &anotherLog) {
 Log& Log::operator = (const Log& anotherLog) {
 	this->par = anotherLog.par;
 	this->firstTime = anotherLog.firstTime;
+	memcpy(this->levels, anotherLog.levels, sizeof(levels));
 	return *this;
 }
 
@@ -36,6 +48,16 @@ Log& Log::operator = (const Log& anotherLog) {
  */
 Log::~Log() {}
 
+/**
+ * FUNCTION NAME: setLevel
+ *
+ * DESCRIPTION: Runtime threshold of a category. Membership keeps at least
+ * 				LOG_INFO, the joins and removals Grader.sh reads.
+ */
+void Log::setLevel(int category, int level) {
+	levels[category] = category == LOG_MEMBERSHIP ? max((int)LOG_INFO, level) : level;
+}
+
 /**
  * FUNCTION NAME: LOG
  *
@@ -43,39 +65,21 @@ Log::~Log() {}
  */
 void Log::LOG(Address *addr, const char * str, ...) {
 
-	static FILE *fp;
-	static FILE *fp2;
 	va_list vararglist;
-	static char buffer[30000];
-	static int numwrites;
+	static char buffer[LOG_LINE_MAX];
 	static char stdstring[30];
-	static char stdstring2[40];
-	static char stdstring3[40]; 
 	static int dbg_opened=0;
 
 	if(dbg_opened != 639){
-		numwrites=0;
-
-		stdstring2[0]=0;
-
-		strcpy(stdstring3, stdstring2);
-
-		strcat(stdstring2, DBG_LOG);
-		strcat(stdstring3, STATS_LOG);
-
-		fp = fopen(stdstring2, "w");
-		fp2 = fopen(stdstring3, "w");
-
+		openFiles();
 		dbg_opened=639;
 	}
-	else 
-
-	sprintf(stdstring, "%d.%d.%d.%d:%d ", addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], *(short *)&addr->addr[4]);
-
-	va_start(vararglist, str);
-	vsprintf(buffer, str, vararglist);
-	va_end(vararglist);
+	else {
+		// the first line goes out without an address, as it always did
+		sprintf(stdstring, "%d.%d.%d.%d:%d ", addr->getByte(0), addr->getByte(1), addr->getByte(2), addr->getByte(3), addr->getPort());
+	}
 
+#if !LOG_EVENTS
 	if (!firstTime) {
 		int magicNumber = 0;
 		string magic = MAGIC_NUMBER;
@@ -83,29 +87,152 @@ void Log::LOG(Address *addr, const char * str, ...) {
 		for ( int i = 0; i < len; i++ ) {
 			magicNumber += (int)magic.at(i);
 		}
-		fprintf(fp, "%x\n", magicNumber);
+		int n = snprintf(buffer, sizeof(buffer), "%x\n", magicNumber);
+		enqueue(DBG_FILE, buffer, n);
 		firstTime = true;
 	}
+#endif
 
-	if(memcmp(buffer, "#STATSLOG#", 10)==0){
-		fprintf(fp2, "\n %s", stdstring);
-		fprintf(fp2, "[%d] ", par->getcurrtime());
+	int prefix = snprintf(buffer, sizeof(buffer), "\n %s[%d] ", stdstring, par->getcurrtime());
+	va_start(vararglist, str);
+	int n = vsnprintf(buffer + prefix, sizeof(buffer) - prefix, str, vararglist);
+	va_end(vararglist);
+	n = prefix + min(n, (int)sizeof(buffer) - prefix - 1);
 
-		fprintf(fp2, buffer);
+	if (memcmp(buffer + prefix, "#STATSLOG#", 10) == 0) {
+		enqueue(STATS_FILE, buffer, n);
+	} else {
+#if LOG_EVENTS
+		events->appendText(par->getcurrtime(), addr, buffer + prefix, n - prefix);
+#else
+		enqueue(DBG_FILE, buffer, n);
+#endif
 	}
-	else{
-		fprintf(fp, "\n %s", stdstring);
-		fprintf(fp, "[%d] ", par->getcurrtime());
-		fprintf(fp, buffer);
+}
 
+/**
+ * FUNCTION NAME: openFiles
+ *
+ * DESCRIPTION: Open dbg.log, or events.bin with LOG_EVENTS, and stats.log.
+ * 				With LOG_ASYNC start the writer. Only the first call opens them.
+ */
+void Log::openFiles() {
+	if (files[STATS_FILE] != NULL) {
+		return;
 	}
+#if LOG_EVENTS
+	events = new EventLog();
+	events->open(EVENTS_LOG);
+	atexit(closeEvents);
+#else
+	files[DBG_FILE] = fopen(DBG_LOG, "w");
+#endif
+	files[STATS_FILE] = fopen(STATS_LOG, "w");
+#if LOG_ASYNC
+	for (int i = 0; i < LOG_RING_FILES; i++) {
+		fds[i] = files[i] != NULL ? fileno(files[i]) : -1;
+	}
+	ring = new LogRing(LOG_RING_BYTES, LOG_FILE_BUFFER);
+	writer = thread(writerLoop);
+	atexit(stopWriter);
+#endif
+}
 
+/**
+ * FUNCTION NAME: enqueue
+ *
+ * DESCRIPTION: Hand a formatted line to its file, DBG_FILE or STATS_FILE
+ */
+void Log::enqueue(int file, const char *data, size_t len) {
+#if LOG_ASYNC
+	// a full ring waits for the writer rather than losing lines
+	while (!ring->push(file, data, len)) {
+		this_thread::yield();
+	}
+#else
+	static int numwrites;
+	fwrite(data, 1, len, files[file]);
 	if(++numwrites >= MAXWRITES){
-		fflush(fp);
-		fflush(fp2);
+		fflush(files[DBG_FILE]);
+		fflush(files[STATS_FILE]);
 		numwrites=0;
 	}
+#endif
+}
+
+/**
+ * FUNCTION NAME: writerLoop
+ *
+ * DESCRIPTION: Body of the writer thread: drain the ring until stopped
+ */
+void Log::writerLoop() {
+	while (!stopping.load(memory_order_acquire)) {
+		if (ring->drain(fds) == 0) {
+			this_thread::sleep_for(chrono::microseconds(LOG_WRITER_IDLE));
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: stopWriter
+ *
+ * DESCRIPTION: Run at exit: stop the writer, then write what is left
+ */
+void Log::stopWriter() {
+	stopping.store(true, memory_order_release);
+	writer.join();
+	ring->drain(fds);
+}
+
+/**
+ * FUNCTION NAME: closeEvents
+ *
+ * DESCRIPTION: Run at exit: trim events.bin to the records written
+ */
+void Log::closeEvents() {
+	events->close();
+}
 
+/**
+ * FUNCTION NAME: flushOnCrash
+ *
+ * DESCRIPTION: Write out every line logged so far, called from a fatal signal
+ * 				handler. Only drains the ring, which is async-signal-safe; the
+ * 				synchronous mode flushes every MAXWRITES lines and events.bin is
+ * 				in the page cache already. If the writer is mid drain it is given
+ * 				a moment to finish, a crash inside drain itself writes nothing more.
+ */
+void Log::flushOnCrash() {
+#if LOG_ASYNC
+	if (ring == NULL || ring->drainingHere()) {
+		return;
+	}
+	struct timespec idle = {0, LOG_WRITER_IDLE * 1000};
+	for (int i = 0; i < 1000 && !ring->empty(); i++) {
+		if (ring->drain(fds) == 0) {
+			nanosleep(&idle, NULL);
+		}
+	}
+#endif
+}
+
+/**
+ * FUNCTION NAME: logEvent
+ *
+ * DESCRIPTION: Log a structured event: a record with LOG_EVENTS, its dbg.log line otherwise
+ */
+void Log::logEvent(Address *thisNode, EventRecord *rec) {
+	rec->tick = (unsigned short)par->getcurrtime();
+	rec->node = (unsigned short)thisNode->getId();
+	rec->nodePort = thisNode->getPort();
+#if LOG_EVENTS
+	openFiles();
+	events->append(rec);
+#else
+	static char text[100];
+	EventLog::format(rec, NULL, text, sizeof(text));
+	LOG(thisNode, "%s", text);
+#endif
 }
 
 /**
@@ -114,9 +241,12 @@ void Log::LOG(Address *addr, const char * str, ...) {
  * DESCRIPTION: To Log a node add
  */
 void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
-	static char stdstring[30];
-	sprintf(stdstring, "Node %d.%d.%d.%d:%d joined at time %d", addedAddr->addr[0], addedAddr->addr[1], addedAddr->addr[2], addedAddr->addr[3], *(short *)&addedAddr->addr[4], par->getcurrtime());
-    LOG(thisNode, stdstring);
+	EventRecord rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.type = EV_JOINED;
+	rec.subject = (unsigned short)addedAddr->getId();
+	rec.subjectPort = addedAddr->getPort();
+	logEvent(thisNode, &rec);
 }
 
 /**
@@ -125,7 +255,53 @@ void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
  * DESCRIPTION: To log a node remove
  */
 void Log::logNodeRemove(Address *thisNode, Address *removedAddr) {
-	static char stdstring[30];
-	sprintf(stdstring, "Node %d.%d.%d.%d:%d removed at time %d", removedAddr->addr[0], removedAddr->addr[1], removedAddr->addr[2], removedAddr->addr[3], *(short *)&removedAddr->addr[4], par->getcurrtime());
-    LOG(thisNode, stdstring);
+	EventRecord rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.type = EV_REMOVED;
+	rec.subject = (unsigned short)removedAddr->getId();
+	rec.subjectPort = removedAddr->getPort();
+	logEvent(thisNode, &rec);
+}
+
+/**
+ * FUNCTION NAME: logNodeFail
+ *
+ * DESCRIPTION: To log the failure of this node, spaced as "time = t" in the multi failure scenario
+ */
+void Log::logNodeFail(Address *thisNode, bool spaced, bool leaving) {
+	EventRecord rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.type = EV_FAILED;
+	rec.arg = (spaced ? EV_FAILED_SPACED : 0) | (leaving ? EV_FAILED_LEAVING : 0);
+	logEvent(thisNode, &rec);
+}
+
+/**
+ * FUNCTION NAME: logNodeSuspect
+ *
+ * DESCRIPTION: To log a node suspected
+ */
+void Log::logNodeSuspect(Address *thisNode, Address *suspectAddr) {
+	EventRecord rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.type = EV_SUSPECTED;
+	rec.subject = (unsigned short)suspectAddr->getId();
+	rec.subjectPort = suspectAddr->getPort();
+	logEvent(thisNode, &rec);
+}
+
+/**
+ * FUNCTION NAME: logProbe
+ *
+ * DESCRIPTION: To log a PING or PONG received, with the last member piggybacked on it
+ */
+void Log::logProbe(Address *thisNode, bool pong, Address *from, char status, int about) {
+	EventRecord rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.type = pong ? EV_PONG : EV_PING;
+	rec.subject = (unsigned short)from->getId();
+	rec.subjectPort = from->getPort();
+	rec.status = status;
+	rec.arg = about;
+	logEvent(thisNode, &rec);
 }
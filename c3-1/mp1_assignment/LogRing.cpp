@@ -0,0 +1,182 @@
+/**********************************
+ * FILE NAME: LogRing.cpp
+ *
+ * DESCRIPTION: Definition of LogRing class
+ **********************************/
+
+#include "LogRing.h"
+
+// set while the calling thread is inside drain
+static thread_local bool inDrain = false;
+
+/**
+ * Constructor, capacity is rounded up to a power of two.
+ * drain writes a file once batch bytes of it are gathered.
+ */
+LogRing::LogRing(size_t capacity, size_t batch): head(0), tail(0) {
+	size_t size = 64;
+	while (size < capacity) {
+		size <<= 1;
+	}
+	buf = (char *) malloc(size);
+	mask = size - 1;
+	draining.clear();
+	outSize = batch;
+	for (int i = 0; i < LOG_RING_FILES; i++) {
+		out[i] = (char *) malloc(batch);
+		outLen[i] = 0;
+	}
+}
+
+/**
+ * Destructor
+ */
+LogRing::~LogRing() {
+	free(buf);
+	for (int i = 0; i < LOG_RING_FILES; i++) {
+		free(out[i]);
+	}
+}
+
+/**
+ * FUNCTION NAME: writeAll
+ *
+ * DESCRIPTION: write(2) all of len bytes, retrying short and interrupted writes
+ */
+static void writeAll(int fd, const char *data, size_t len) {
+	while (len > 0) {
+		ssize_t n = ::write(fd, data, len);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return;
+		}
+		data += n;
+		len -= n;
+	}
+}
+
+/**
+ * FUNCTION NAME: flushOut
+ *
+ * DESCRIPTION: Write the text gathered for a file
+ */
+void LogRing::flushOut(const int *fds, int file) {
+	if (fds[file] >= 0) {
+		writeAll(fds[file], out[file], outLen[file]);
+	}
+	outLen[file] = 0;
+}
+
+/**
+ * FUNCTION NAME: stage
+ *
+ * DESCRIPTION: Gather text for a file, writing it out once the batch is full
+ */
+void LogRing::stage(const int *fds, int file, const char *data, size_t len) {
+	if (outLen[file] + len > outSize) {
+		flushOut(fds, file);
+	}
+	if (len > outSize) {
+		if (fds[file] >= 0) {
+			writeAll(fds[file], data, len);
+		}
+		return;
+	}
+	memcpy(out[file] + outLen[file], data, len);
+	outLen[file] += len;
+}
+
+/**
+ * FUNCTION NAME: copyIn
+ *
+ * DESCRIPTION: Copy bytes to a ring position, wrapping at the end
+ */
+void LogRing::copyIn(size_t pos, const char *data, size_t len) {
+	size_t at = pos & mask;
+	size_t first = min(len, mask + 1 - at);
+	memcpy(buf + at, data, first);
+	memcpy(buf, data + first, len - first);
+}
+
+/**
+ * FUNCTION NAME: push
+ *
+ * DESCRIPTION: Append a record for a file. Producer side only.
+ *
+ * RETURNS:
+ * false if the ring has no room for it yet
+ */
+bool LogRing::push(int file, const char *data, size_t len) {
+	size_t h = head.load(memory_order_relaxed);
+	size_t need = sizeof(uint32_t) + len;
+	if (need > mask + 1 - (h - tail.load(memory_order_acquire))) {
+		return false;
+	}
+	uint32_t hdr = (uint32_t)(len << 1 | file);
+	copyIn(h, (const char *)&hdr, sizeof(hdr));
+	copyIn(h + sizeof(hdr), data, len);
+	head.store(h + need, memory_order_release);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: drain
+ *
+ * DESCRIPTION: Write every published record to its file descriptor and free it.
+ * 				Consumer side; returns at once if another drain is running.
+ * 				Only memcpy and write(2), so a signal handler may call it.
+ *
+ * RETURNS:
+ * bytes of records drained
+ */
+size_t LogRing::drain(const int *fds) {
+	if (draining.test_and_set(memory_order_acquire)) {
+		return 0;
+	}
+	inDrain = true;
+	size_t t = tail.load(memory_order_relaxed);
+	size_t h = head.load(memory_order_acquire);
+	size_t start = t;
+	while (t < h) {
+		uint32_t hdr;
+		size_t at = t & mask;
+		size_t first = min(sizeof(hdr), mask + 1 - at);
+		memcpy(&hdr, buf + at, first);
+		memcpy((char *)&hdr + first, buf, sizeof(hdr) - first);
+		size_t len = hdr >> 1;
+		int file = hdr & 1;
+		at = (t + sizeof(hdr)) & mask;
+		first = min(len, mask + 1 - at);
+		stage(fds, file, buf + at, first);
+		stage(fds, file, buf, len - first);
+		t += sizeof(hdr) + len;
+	}
+	// everything is written before the records are freed
+	for (int i = 0; i < LOG_RING_FILES; i++) {
+		flushOut(fds, i);
+	}
+	tail.store(t, memory_order_release);
+	inDrain = false;
+	draining.clear(memory_order_release);
+	return t - start;
+}
+
+/**
+ * FUNCTION NAME: empty
+ *
+ * DESCRIPTION: true once the consumer has caught up with the producer
+ */
+bool LogRing::empty() {
+	return tail.load(memory_order_acquire) == head.load(memory_order_acquire);
+}
+
+/**
+ * FUNCTION NAME: drainingHere
+ *
+ * DESCRIPTION: true if the calling thread is inside drain, e.g. it crashed there
+ */
+bool LogRing::drainingHere() {
+	return inDrain;
+}
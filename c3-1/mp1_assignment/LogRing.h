@@ -0,0 +1,57 @@
+/**********************************
+ * FILE NAME: LogRing.h
+ *
+ * DESCRIPTION: Header file of LogRing class
+ **********************************/
+
+#ifndef LOGRING_H_
+#define LOGRING_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// files a record may go to
+#define LOG_RING_FILES 2
+
+/**
+ * CLASS NAME: LogRing
+ *
+ * DESCRIPTION: Lock-free single-producer single-consumer byte ring of log
+ * 				records. A record is a 4 byte header, length << 1 | file, and
+ * 				the text, and may wrap around the end. The producer publishes
+ * 				records by advancing head, the consumer frees them by advancing
+ * 				tail; both only grow, the capacity is a power of two. A flag
+ * 				keeps a crash flush from draining along with the writer.
+ * 				drain gathers the text per file and writes it with write(2),
+ * 				all of it before it returns, so it can run in a signal handler.
+ */
+class LogRing {
+private:
+	char *buf;
+	size_t mask;
+	atomic<size_t> head;
+	// keeps the producer's and the consumer's counters on separate cache lines
+	char pad[64];
+	atomic<size_t> tail;
+	atomic_flag draining;
+	// text gathered per file by drain
+	char *out[LOG_RING_FILES];
+	size_t outLen[LOG_RING_FILES];
+	size_t outSize;
+	void copyIn(size_t pos, const char *data, size_t len);
+	void stage(const int *fds, int file, const char *data, size_t len);
+	void flushOut(const int *fds, int file);
+	LogRing(const LogRing &);
+	LogRing &operator =(const LogRing &);
+public:
+	LogRing(size_t capacity, size_t batch);
+	virtual ~LogRing();
+	bool push(int file, const char *data, size_t len);
+	size_t drain(const int *fds);
+	bool empty();
+	bool drainingHere();
+};
+
+#endif /* LOGRING_H_ */
@@ -6,33 +6,112 @@
  **********************************/
 
 #include "MP1Node.h"
-#include <byteswap.h>
-#include <sstream>
 
 /*
  * Note: You can change/add any functions in MP1Node.{h,cpp}
  */
 
+/**
+ * FUNCTION NAME: memberKey
+ *
+ * DESCRIPTION: Key of an id and port in memberIndex
+ */
+static long long memberKey(int id, short port) {
+	return (long long)Address(id, port).key;
+}
+
+/**
+ * FUNCTION NAME: addressKey
+ *
+ * DESCRIPTION: memberKey of an address
+ */
+static long long addressKey(Address *addr) {
+	return (long long)addr->key;
+}
+
+/**
+ * FUNCTION NAME: eventKey
+ *
+ * DESCRIPTION: Key of a BROADCAST, its origin and the low bits of its sequence number
+ */
+static unsigned long long eventKey(Address *origin, unsigned int seq) {
+	return ((unsigned long long)addressKey(origin) << 16) | (seq & 0xffff);
+}
+
+/**
+ * FUNCTION NAME: keyAddress
+ *
+ * DESCRIPTION: Address of a memberKey
+ */
+static Address keyAddress(long long key) {
+	return Address((unsigned long long)key);
+}
+
 /**
  * Overloaded Constructor of the MP1Node class
  * You can add new members to the class if you think it
  * is necessary for your logic to work
  */
 MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Address *address) {
-	for( int i = 0; i < 6; i++ ) {
-		NULLADDR[i] = 0;
-	}
 	this->memberNode = member;
 	this->emulNet = emul;
 	this->log = log;
 	this->par = params;
 	this->memberNode->addr = *address;
+	this->droppedMsgs = 0;
+	this->nextSnapshot = 0;
+	this->joinSnapshot = 0;
+	this->joinMissing = 0;
+	this->joinProgress = 0;
+	this->joinSent = 0;
+	this->joinAttempts = 0;
+	this->joinRedirects = 0;
+	this->joinsHandled = 0;
+	this->joinsRedirected = 0;
+	this->joinLoad = 0;
+	this->joinLoadTick = 0;
+	this->joinFailovers = 0;
+	this->suspicions = 0;
+	this->refutedSuspicions = 0;
+	this->removals = 0;
+	this->neighborSent = -1;
+	this->broadcastSeq = 0;
+	this->shuffles = 0;
+	this->broadcasts = 0;
+	this->broadcastDuplicates = 0;
+	this->grafts = 0;
+	this->prunes = 0;
+	this->gossipReceived = 0;
+	this->gossipApplied = 0;
+	this->pingBatch = true;
+	this->recvTick = -1;
+	this->recvAllocs = 0;
+	this->recvPooled = 0;
+	this->left = false;
+	this->incarnation = 0;
+	this->leavesReceived = 0;
+	this->sendsDeferred = 0;
+	this->sendsTrimmed = 0;
+#ifdef COROUTINES
+	this->sched = NULL;
+	this->msgWaiter = nullptr;
+#endif
+	this->syncRounds = 0;
+	this->syncEntries = 0;
+	this->syncBytes = 0;
 }
 
 /**
  * Destructor of the MP1Node class
  */
-MP1Node::~MP1Node() {}
+MP1Node::~MP1Node() {
+#ifdef COROUTINES
+	// the receiver of a failed node waits for messages that never come
+	if (msgWaiter) {
+		msgWaiter.destroy();
+	}
+#endif
+}
 
 /**
  * FUNCTION NAME: recvLoop
@@ -45,7 +124,18 @@ int MP1Node::recvLoop() {
     	return false;
     }
     else {
+#ifdef DEBUGALLOC
+    	// the other nodes run before this node's nodeLoop, so count the queueing apart
+    	unsigned long allocs = allocCount();
+    	long pooled = InboxMsg::getPooled();
+    	int received = emulNet->ENrecv(&(memberNode->addr), enqueueWrapper, NULL, 1, &(memberNode->mp1q));
+    	recvTick = par->getcurrtime();
+    	recvAllocs = allocCount() - allocs;
+    	recvPooled = InboxMsg::getPooled() - pooled;
+    	return received;
+#else
     	return emulNet->ENrecv(&(memberNode->addr), enqueueWrapper, NULL, 1, &(memberNode->mp1q));
+#endif
     }
 }
 
@@ -56,7 +146,7 @@ int MP1Node::recvLoop() {
  */
 int MP1Node::enqueueWrapper(void *env, char *buff, int size) {
 	Queue q;
-	return q.enqueue((queue<q_elt> *)env, (void *)buff, size);
+	return q.enqueue((Inbox *)env, (void *)buff, size);
 }
 
 /**
@@ -72,20 +162,21 @@ void MP1Node::nodeStart(char *servaddrstr, short servport) {
 
     // Self booting routines
     if( initThisNode(&joinaddr) == -1 ) {
-#ifdef DEBUGLOG
-        log->LOG(&memberNode->addr, "init_thisnode failed. Exit.");
-#endif
+        LOG_AT(log, LOG_MEMBERSHIP, LOG_ERROR, &memberNode->addr, "init_thisnode failed. Exit.");
         exit(1);
     }
 
     if( !introduceSelfToGroup(&joinaddr) ) {
         finishUpThisNode();
-#ifdef DEBUGLOG
-        log->LOG(&memberNode->addr, "Unable to join self to group. Exiting.");
-#endif
+        LOG_AT(log, LOG_MEMBERSHIP, LOG_ERROR, &memberNode->addr, "Unable to join self to group. Exiting.");
         exit(1);
     }
 
+#ifdef COROUTINES
+    // the protocol runs in coroutines resumed by the Application's scheduler instead of nodeLoop
+    receiveTask();
+    tickTask();
+#endif
     return;
 }
 
@@ -107,6 +198,22 @@ int MP1Node::initThisNode(Address *joinaddr) {
 	memberNode->pingCounter = TFAIL;
 	memberNode->timeOutCounter = -1;
     initMemberListTable(memberNode);
+    probes.clear();
+    memberIndex.clear();
+    suspects.clear();
+    removed.clear();
+    pendingProbes.clear();
+    joinFragments.clear();
+    joinMissing = 0;
+    if (par->PARTIAL_VIEW) {
+    	view.init(par->EN_GPSZ);
+    }
+    neighborSent = -1;
+    seenEvents.clear();
+    seenOrder = queue<unsigned long long>();
+    lazyPeers.clear();
+    missingEvents.clear();
+    lazyQueue.clear();
 
     return 0;
 }
@@ -118,36 +225,27 @@ int MP1Node::initThisNode(Address *joinaddr) {
  */
 int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 //	MessageHdr *msg;
-#ifdef DEBUGLOG
-    static char s[1024];
-#endif
     if ( memberNode->addr == *joinaddr) {
         // I am the group booter (first process to join the group). Boot up the group
-#ifdef DEBUGLOG
-        log->LOG(&memberNode->addr, "Starting up group...");
-#endif
+        LOG_AT(log, LOG_MEMBERSHIP, LOG_TRACE, &memberNode->addr, "Starting up group...");
         memberNode->inGroup = true;
 
-        IdPort idPort = *(IdPort*)memberNode->addr.addr;
-		int id = idPort.getId();
-		short port = idPort.getPort();
-		memberNode->memberList.push_back(MemberListEntry(id, port));
-//		memberNode->memberList.push_back(MemberListEntry(idPort.getId(), idPort.getPort()));
+        // the active view only holds other nodes
+        if (par->PARTIAL_VIEW) {
+        	return 1;
+        }
+
+		int id = memberNode->addr.getId();
+		short port = memberNode->addr.getPort();
+		memberIndex[memberKey(id, port)] = memberNode->memberList.size();
+		memberNode->memberList.push_back(MemberListEntry(id, port, memberNode->heartbeat, par->getcurrtime()));
 
     }
     else {
-#ifdef DEBUGLOG
-        sprintf(s, "Trying to join...");
-        log->LOG(&memberNode->addr, s);
-#endif
+        LOG_AT(log, LOG_MEMBERSHIP, LOG_TRACE, &memberNode->addr, "Trying to join...");
 
         // send JOINREQ message to introducer member
-    	JoinReqPkg joinPkg;
-    	joinPkg.hdr.msgType = JOINREQ;
-    	joinPkg.adr = memberNode->addr;
-    	joinPkg.hrt = memberNode->heartbeat;
-
-        emulNet->ENsend(&memberNode->addr, joinaddr, (char *) &joinPkg, sizeof(JoinReqPkg));
+        sendJoinReq(joinaddr);
 
     }
 
@@ -158,15 +256,72 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 /**
  * FUNCTION NAME: finishUpThisNode
  *
- * DESCRIPTION: Wind up this node and clean up state
+ * DESCRIPTION: Wind up this node and clean up state.
+ * 				Planned leaves go through Application::leaveNode, at the end of the
+ * 				run the network is already down and a LEAVE would reach nobody.
  */
 int MP1Node::finishUpThisNode(){
-   /*
-    * Your code goes here
-    */
+	LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "#STATSLOG# dropped malformed messages %ld", droppedMsgs);
+	LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "#STATSLOG# inbox refused %ld", memberNode->mp1q.getRefused());
+	LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "#STATSLOG# joins handled %ld redirected %ld failovers %ld",
+			joinsHandled, joinsRedirected, joinFailovers);
+	LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "#STATSLOG# suspicions %ld refuted %ld removals %ld health %d incarnation %u",
+			suspicions, refutedSuspicions, removals, health.getScore(), incarnation);
+	LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "#STATSLOG# leaves received %ld", leavesReceived);
+	LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "#STATSLOG# sends deferred %ld trimmed %ld still deferred %d tokens %ld",
+			sendsDeferred, sendsTrimmed, (int)deferredSends.size(), budget.getTokens());
+	LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "#STATSLOG# gossip entries received %ld applied %ld", gossipReceived, gossipApplied);
+	LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "#STATSLOG# gossip fanout %d interval %d for N %d ack loss %.3f convergence %.0f ticks %.1f B/tick",
+			gossipCtl.getFanout(), gossipCtl.getInterval(), gossipCtl.getGroupSize(), gossipCtl.getAckLoss(),
+			gossipCtl.getConvergence(), gossipCtl.getBytesRate());
+	LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "#STATSLOG# anti-entropy rounds %ld entries sent %ld bytes sent %ld",
+			syncRounds, syncEntries, syncBytes);
+	if (par->PARTIAL_VIEW) {
+		LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "#STATSLOG# active view %d passive view %d shuffles %ld broadcasts %ld",
+				memberNode->nnb, (int)view.passiveSize(), shuffles, broadcasts);
+		LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "#STATSLOG# broadcast duplicates %ld grafts %ld prunes %ld",
+				broadcastDuplicates, grafts, prunes);
+	}
 	return 0;
 }
 
+/**
+ * FUNCTION NAME: leaveGroup
+ *
+ * DESCRIPTION: Tell the group this node is shutting down, so its members drop it
+ * 				at once instead of suspecting it for TFAIL to TREMOVE ticks
+ */
+void MP1Node::leaveGroup() {
+	if (left || memberNode->bFailed || !memberNode->inGroup) {
+		return;
+	}
+	left = true;
+	// newer than anything gossiped about this node so far
+	memberNode->heartbeat++;
+
+	if (par->PARTIAL_VIEW) {
+		// the IHAVEs for lazy peers would never be flushed, push to every neighbour
+		lazyPeers.clear();
+		broadcast(DEAD, &memberNode->addr);
+	} else {
+		char buf[LEAVE_WIRE_MAX];
+		WireWriter w(buf, sizeof(buf));
+		w.putHeader(LEAVE);
+		w.putAddress(&memberNode->addr);
+		w.putVarint(incarnation);
+		w.putZigzag(memberNode->heartbeat);
+		for (size_t i = 0; i < memberNode->memberList.size(); ++i) {
+			MemberListEntry *mle = &memberNode->memberList[i];
+			Address to = Address(mle->id, mle->port);
+			if (!(to == memberNode->addr)) {
+				// the node stops right after, a deferred LEAVE would never go out
+				sendMessage(&to, buf, w.size(), SEND_PROBE);
+			}
+		}
+	}
+	memberNode->inGroup = false;
+}
+
 /**
  * FUNCTION NAME: nodeLoop
  *
@@ -178,9 +333,18 @@ void MP1Node::nodeLoop() {
     	return;
     }
 
+#ifdef DEBUGALLOC
+    TickAllocs tick;
+    startTickAllocs(&tick);
+#endif
+
     // Check my messages
     checkMessages();
 
+    // Ask for JOINREP fragments that did not arrive
+    checkJoin();
+    expireJoinSnapshots();
+
     // Wait until you're in the group...
     if( !memberNode->inGroup ) {
     	return;
@@ -189,6 +353,9 @@ void MP1Node::nodeLoop() {
     // ...then jump in and share your responsibilites!
     nodeLoopOps();
 
+#ifdef DEBUGALLOC
+    checkTickAllocs(&tick);
+#endif
     return;
 }
 
@@ -198,19 +365,219 @@ void MP1Node::nodeLoop() {
  * DESCRIPTION: Check messages in the queue and call the respective message handler
  */
 void MP1Node::checkMessages() {
-    void *ptr;
-    int size;
-
-    // Pop waiting messages from memberNode's mp1q
-    while ( !memberNode->mp1q.empty() ) {
-    	ptr = memberNode->mp1q.front().elt;
-    	size = memberNode->mp1q.front().size;
-    	memberNode->mp1q.pop();
-    	recvCallBack((void *)memberNode, (char *)ptr, size);
+    health.setQueueDepth(memberNode->mp1q.size());
+
+    // Pop all waiting messages from memberNode's mp1q
+    InboxMsg *popped[INBOX_CAPACITY];
+    unsigned char types[INBOX_CAPACITY];
+    size_t n = memberNode->mp1q.popBatch(popped, INBOX_CAPACITY);
+    size_t start[DUMMYLASTMSGTYPE + 1];
+    memset(start, 0, sizeof(start));
+    pingBatch = true;
+    for (size_t i = 0; i < n; ++i) {
+    	if (!getMessageType(popped[i]->data(), popped[i]->size, &types[i]) || types[i] > DUMMYLASTMSGTYPE) {
+    		types[i] = DUMMYLASTMSGTYPE;
+    	}
+    	pingBatch = pingBatch && (types[i] == PING || types[i] == PONG);
+    	start[types[i]]++;
+    }
+
+    // handle them grouped by type, in arrival order within a type.
+    // A counting sort, unlike stable_sort, needs no temporary buffer.
+    size_t pos = 0;
+    for (int t = 0; t <= DUMMYLASTMSGTYPE; ++t) {
+    	size_t count = start[t];
+    	start[t] = pos;
+    	pos += count;
+    }
+    batch.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+    	QueuedMsg *msg = &batch[start[types[i]]++];
+    	msg->elt = popped[i];
+    	msg->type = types[i];
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+    	InboxMsg *msg = batch[i].elt;
+    	if (!recvCallBack((void *)memberNode, msg->data(), msg->size)) {
+    		droppedMsgs++;
+    		LOG_AT(log, LOG_NETWORK, LOG_ERROR, &memberNode->addr, "malformed message of %d bytes dropped", msg->size);
+    	}
+    	InboxMsg::destroy(msg);
+    }
+
+    // then apply the merged membership updates once, and reply
+    applyUpdates();
+    for (size_t i = 0; i < pongs.size(); ++i) {
+    	sendPing(&pongs[i], PONG);
+    }
+    pongs.clear();
+
+    if (!pendingJoins.empty()) {
+    	answerJoins();
     }
     return;
 }
 
+/**
+ * FUNCTION NAME: queueUpdate
+ *
+ * DESCRIPTION: Merge a received member entry into the updates of this tick.
+ * 				Per member only what applyGossip would end up with is kept:
+ * 				the newest entry by compareStatus, and apart from it the ALIVE
+ * 				entry with the highest heartbeat heard, since applyGossip takes
+ * 				a newer heartbeat from any ALIVE entry. The senders of an equal
+ * 				suspicion are kept as its confirmers.
+ */
+void MP1Node::queueUpdate(const MemberStatusInfo *entry, Address *from) {
+	gossipReceived++;
+	long long key = memberKey(entry->info.id, entry->info.port);
+	// at most half full, so probe sequences stay short
+	if ((updates.size() + 1) * 2 > updateSlots.size()) {
+		growUpdateSlots();
+	}
+	size_t slot;
+	GossipUpdate *update = findUpdate(key, &slot);
+	if (update == NULL) {
+		GossipUpdate fresh;
+		fresh.key = key;
+		fresh.slot = slot;
+		fresh.entry = *entry;
+		fresh.from[0] = *from;
+		fresh.n = 1;
+		fresh.hasAlive = entry->status == ALIVE;
+		if (fresh.hasAlive) {
+			fresh.alive = *entry;
+			fresh.aliveFrom = *from;
+		}
+		updates.push_back(fresh);
+		updateSlots[slot] = updates.size();
+		return;
+	}
+
+	if (entry->status == ALIVE && (!update->hasAlive || entry->info.heartbeat > update->alive.info.heartbeat)) {
+		update->hasAlive = true;
+		update->alive = *entry;
+		update->aliveFrom = *from;
+	}
+	int order = compareStatus(entry, &update->entry);
+	if (order > 0) {
+		update->entry = *entry;
+		update->from[0] = *from;
+		update->n = 1;
+	} else if (order == 0) {
+		update->entry.info.heartbeat = max(update->entry.info.heartbeat, entry->info.heartbeat);
+		if (entry->status == ALIVE || update->n >= SUSPICION_K) {
+			return;
+		}
+		for (int i = 0; i < update->n; ++i) {
+			if (update->from[i] == *from) {
+				return;
+			}
+		}
+		update->from[update->n++] = *from;
+	}
+}
+
+/**
+ * FUNCTION NAME: applyUpdates
+ *
+ * DESCRIPTION: Apply the merged member entries of this tick
+ */
+void MP1Node::applyUpdates() {
+	for (size_t i = 0; i < updates.size(); ++i) {
+		GossipUpdate *u = &updates[i];
+		// the highest heartbeat first, unless the winner carries it anyway
+		if (u->hasAlive && !(u->entry.status == ALIVE && u->entry.info.heartbeat >= u->alive.info.heartbeat)) {
+			applyGossip(&u->alive, &u->aliveFrom);
+		}
+		for (int f = 0; f < u->n; ++f) {
+			applyGossip(&u->entry, &u->from[f]);
+		}
+	}
+	gossipApplied += updates.size();
+	for (size_t i = 0; i < updates.size(); ++i) {
+		updateSlots[updates[i].slot] = 0;
+	}
+	updates.clear();
+}
+
+/**
+ * FUNCTION NAME: findUpdate
+ *
+ * DESCRIPTION: Look up the update of a member by linear probing.
+ * 				slot is set to its position, or to the free one it would take.
+ *
+ * RETURNS:
+ * NULL if there is no update for the member yet
+ */
+GossipUpdate *MP1Node::findUpdate(long long key, size_t *slot) {
+	size_t mask = updateSlots.size() - 1;
+	size_t i = AddressHash()(key) & mask;
+	while (updateSlots[i] != 0) {
+		GossipUpdate *update = &updates[updateSlots[i] - 1];
+		if (update->key == key) {
+			*slot = i;
+			return update;
+		}
+		i = (i + 1) & mask;
+	}
+	*slot = i;
+	return NULL;
+}
+
+/**
+ * FUNCTION NAME: growUpdateSlots
+ *
+ * DESCRIPTION: Double the index of the updates and reinsert them.
+ * 				The index keeps its size across ticks, so this stops once the
+ * 				largest batch has been seen.
+ */
+void MP1Node::growUpdateSlots() {
+	updateSlots.assign(max((size_t)UPDATE_SLOTS_MIN, updateSlots.size() * 2), 0);
+	for (size_t i = 0; i < updates.size(); ++i) {
+		findUpdate(updates[i].key, &updates[i].slot);
+		updateSlots[updates[i].slot] = i + 1;
+	}
+}
+
+/**
+ * FUNCTION NAME: startTickAllocs
+ *
+ * DESCRIPTION: Remember the allocation count and membership state before a tick
+ */
+void MP1Node::startTickAllocs(TickAllocs *tick) {
+	tick->allocs = allocCount();
+	tick->members = memberNode->memberList.size();
+	tick->suspicions = suspicions;
+	tick->refutedSuspicions = refutedSuspicions;
+	tick->removals = removals;
+	tick->syncRounds = syncRounds;
+	tick->sendsDeferred = sendsDeferred;
+	tick->capacity = batch.capacity() + updates.capacity() + updateSlots.capacity() + pongs.capacity()
+			+ pendingProbes.capacity() + memberNode->memberList.capacity() + deferredSends.capacity();
+}
+
+/**
+ * FUNCTION NAME: checkTickAllocs
+ *
+ * DESCRIPTION: Assert that a steady state tick, which only exchanged PINGs and PONGs
+ * 				with known members, did not allocate. Ticks that changed the membership,
+ * 				ran anti-entropy, deferred a send or grew a buffer are skipped. So is the partial view
+ * 				mode, whose overlay maintenance runs every tick, and a tick whose recvLoop
+ * 				grew the inbox message pool. The allocations of recvLoop count as the tick's.
+ */
+void MP1Node::checkTickAllocs(TickAllocs *tick) {
+	TickAllocs now;
+	startTickAllocs(&now);
+	if (recvTick != par->getcurrtime() || recvPooled != 0
+			|| par->PARTIAL_VIEW || !pingBatch || now.members != tick->members || now.suspicions != tick->suspicions
+			|| now.refutedSuspicions != tick->refutedSuspicions || now.removals != tick->removals
+			|| now.syncRounds != tick->syncRounds || now.sendsDeferred != tick->sendsDeferred || now.capacity != tick->capacity) {
+		return;
+	}
+	assert(now.allocs == tick->allocs && recvAllocs == 0);
+}
+
 /**
  * FUNCTION NAME: recvCallBack
  *
@@ -220,269 +587,1883 @@ bool MP1Node::recvCallBack(void *env, char *data, int size ) {
 	/*
 	 * Your code goes here
 	 */
-	MessageHdr *msg;
-	msg = (MessageHdr*) data;
-	switch (msg->msgType) {
+	unsigned char type;
+	if (!getMessageType(data, size, &type)) {
+		return false;
+	}
+	switch (type) {
 	case JOINREQ: {
-		JoinReqPkg* p = (JoinReqPkg*) data;
-		Address addr = p->adr;
-
-		log->logNodeAdd(&memberNode->addr, &addr);
-
-		// reply with JOINREP
-        vector<MemberListEntry> memberList = memberNode->memberList;
-		size_t n = memberList.size();
-
-        size_t msgsize = sizeof(JoinRepPkg) + n * sizeof(MemberInfo);
-        JoinRepPkg* joinRep = (JoinRepPkg*) malloc(msgsize);
-    	joinRep->hdr.msgType = JOINREP;
-    	joinRep->n = n;
-
-    	MemberInfo *members = &joinRep->member;
-        for(vector<MemberListEntry>::iterator memberIterator = memberList.begin();
-                memberIterator != memberList.end();
-                memberIterator++) {
-        	MemberListEntry member = *memberIterator;
-        	MemberInfo memberInfo;
-        	memberInfo.id = member.id;
-        	memberInfo.port = member.port;
-        	memberInfo.heartbeat = member.heartbeat;
-        	*members = memberInfo;
-            ++members;
-        }
+		JoinReqView req;
+		if (!req.parse(data, size)) {
+			return false;
+		}
+		// answered together with the other joiners of this tick, see answerJoins
+		pendingJoins.push_back(req);
+	} break;
+	case JOINREDIRECT: {
+		JoinRedirectView redirect;
+		if (!redirect.parse(data, size)) {
+			return false;
+		}
+		if (!memberNode->inGroup) {
+			LOG_AT(log, LOG_MEMBERSHIP, LOG_TRACE, &memberNode->addr, "JOINREDIRECT to %s", redirect.addr.getAddress().c_str());
+			joinRedirects++;
+			sendJoinReq(&redirect.addr);
+		}
+	} break;
+	case JOINREP: {
+		JoinRepView rep;
+		if (!rep.parse(data, size)) {
+			return false;
+		}
 
-        IdPort idPort = *(IdPort*)&addr;
-		int id = idPort.getId();
-		short port = idPort.getPort();
-		memberNode->memberList.push_back(MemberListEntry(id, port));
-//		memberNode->memberList.push_back(MemberListEntry(idPort.getId(), idPort.getPort()));
-		memberNode->nnb++;
-
-#ifdef DEBUGLOG
-        static char s[1024];
-        sprintf(s, "JOINREQ received ... send JOINREP");
-        log->LOG(&memberNode->addr, s);
-#endif
+		// track fragments of the first snapshot, or of a newer one while still incomplete
+		if (joinFragments.empty() || (joinMissing > 0 && (rep.snapshot != joinSnapshot || !(rep.addr == joinFrom)))) {
+			joinFrom = rep.addr;
+			joinSnapshot = rep.snapshot;
+			joinFragments.assign(rep.fragments, false);
+			joinMissing = rep.fragments;
+		}
+		if (rep.snapshot == joinSnapshot && rep.addr == joinFrom && !joinFragments[rep.fragment]) {
+			joinFragments[rep.fragment] = true;
+			joinMissing--;
+			joinProgress = par->getcurrtime();
+		}
 
+		if (!memberNode->inGroup) {
+			memberNode->inGroup = true;
+			LOG_AT(log, LOG_MEMBERSHIP, LOG_TRACE, &memberNode->addr, "JOINREP ... node has joined group");
+		}
 
-        // send JOINREP message to member
-        emulNet->ENsend(&memberNode->addr, &addr, (char *) joinRep, msgsize);
+		for (MemberListView::iterator it = rep.members.begin(); it != rep.members.end(); ++it) {
+			queueUpdate(&*it, &rep.addr);
+		}
 
-        free(joinRep);
 	} break;
-	case JOINREP: {
-        memberNode->inGroup = true;
-#ifdef DEBUGLOG
-		log->LOG(&memberNode->addr, "JOINREP ... node has joined group");
-#endif
-		JoinRepPkg* p = (JoinRepPkg*) data;
-		size_t n = p->n;
-
-		MemberInfo* memberInfo = &((JoinRepPkg*)data)->member;
-		for (size_t i=0; i < n; ++i) {
-/*			int id = __bswap_32 (memberInfo->id);
-			short port = __bswap_16 (memberInfo->port);
-			MemberListEntry member = MemberListEntry(MemberListEntry(id ,port));*/
-			MemberListEntry member = MemberListEntry(MemberListEntry(memberInfo->id ,memberInfo->port));
-			memberNode->memberList.push_back(member);
-			ostringstream address;
-			address << member.id << ":" << member.port;
-			Address addr = Address(address.str());
-			log->logNodeAdd(&memberNode->addr, &addr);
-			memberNode->nnb++;
-			memberInfo++;
+	case JOINFRAGREQ: {
+		JoinFragReqView req;
+		if (!req.parse(data, size)) {
+			return false;
 		}
-
+		resendJoinFragments(&req);
 	} break;
-	case PING: {
-		PingPkg* p = (PingPkg*) data;
-		Address addr = p->adr;
-		int a = p->member.info.id;
-		MemberStatus stat = p->member.status;
-        static char s[1024];
-        sprintf(s, "PING received from node %s, %c%d", addr.getAddress().c_str(), memberStatus(stat), a);
-        log->LOG(&memberNode->addr, s);
-
-		PongPkg pongPkg;
-		pongPkg.hdr.msgType = PONG;
-		pongPkg.adr = memberNode->addr;
-		if (memberNode->nnb > 1) {
-			size_t inode = rand() % memberNode->nnb;
-			MemberListEntry mle = memberNode->memberList[inode];
-			pongPkg.n = 1;
-			MemberInfo info;
-			info.id = mle.id; info.port = mle.port; info.heartbeat = mle.heartbeat;
-			pongPkg.member.status = ALIVE;
-			pongPkg.member.info = info;
-        } else {
-			pongPkg.n = 0;
-        }
-		emulNet->ENsend(&memberNode->addr, &addr, (char *) &pongPkg, sizeof(PingPkg));
-			/*
-		ostringstream address;
-		address << memberNode->memberList[node].id << ":" << memberNode->memberList[node].port;
-		Address addr = Address(address.str());
-*/
-		if (!inMemberList(&addr)) {
-			log->logNodeAdd(&memberNode->addr, &addr);
-	        IdPort idPort = *(IdPort*)&addr;
-			int id = idPort.getId();
-			short port = idPort.getPort();
-			memberNode->memberList.push_back(MemberListEntry(id, port));
-			memberNode->nnb++;
+	case PING:
+	case PONG: {
+		PingView ping;
+		if (!ping.parse(data, size)) {
+			return false;
+		}
+		Address addr = ping.addr;
+		if (LOG_ENABLED(log, LOG_NETWORK, LOG_TRACE)) {
+			// the line shows the last member piggybacked
+			MemberStatus stat = ALIVE;
+			int a = 0;
+			for (MemberListView::iterator it = ping.members.begin(); it != ping.members.end(); ++it) {
+				stat = it->status;
+				a = it->info.id;
+			}
+			log->logProbe(&memberNode->addr, type == PONG, &addr, memberStatus(stat), a);
+		}
+
+		// hearing from the sender directly proves it is alive
+		MemberListEntry *sender = findMember(&addr);
+		if (sender == NULL && par->PARTIAL_VIEW) {
+			// a PING makes the link symmetric if there is room, like a low priority NEIGHBOR
+			if (type == PING && memberNode->nnb < (int)view.getActiveMax()) {
+				addNeighbor(&addr);
+			} else {
+				mergePassive(&addr);
+			}
+		} else if (sender == NULL) {
+			addMember(&addr, 0);
+		} else {
+			sender->joinLoad = ping.joinLoad;
+			if (suspects.erase(memberKey(sender->id, sender->port)) > 0) {
+				refutedSuspicions++;
+			}
+		}
+		for (MemberListView::iterator it = ping.members.begin(); it != ping.members.end(); ++it) {
+			queueUpdate(&*it, &addr);
+		}
 
+		if (type == PING) {
+			// answered after the batch, once per sender, carrying the merged state
+			if (find(pongs.begin(), pongs.end(), addr) == pongs.end()) {
+				pongs.push_back(addr);
+			}
+		} else {
+#ifdef COROUTINES
+			ackProbe(&addr);
+#else
+			for (size_t i = 0; i < pendingProbes.size(); ++i) {
+				if (pendingProbes[i].addr == addr) {
+					pendingProbes.erase(pendingProbes.begin() + i);
+					health.probeAcked();
+					gossipCtl.ackReceived();
+					break;
+				}
+			}
+#endif
 		}
 	} break;
-	case PONG: {
-		PongPkg* p = (PongPkg*) data;
-		Address adr = p->adr;
-		int a = p->member.info.id;
-		MemberStatus stat = p->member.status;
-        static char s[1024];
-        sprintf(s, "PONG received from node %s, %c%d", adr.getAddress().c_str(), memberStatus(stat), a);
-        log->LOG(&memberNode->addr, s);
+	case FORWARDJOIN: {
+		OverlayView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		forwardJoin(&msg);
 	} break;
-	case DUMMYLASTMSGTYPE: {
-
+	case NEIGHBOR: {
+		OverlayView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		// high priority requests come from joiners' contacts and from nodes without any neighbour
+		bool accept = msg.arg == 1 || memberNode->nnb < (int)view.getActiveMax() || inMemberList(&msg.addr);
+		if (accept) {
+			addNeighbor(&msg.addr);
+			if (!memberNode->inGroup) {
+				memberNode->inGroup = true;
+				LOG_AT(log, LOG_MEMBERSHIP, LOG_TRACE, &memberNode->addr, "NEIGHBOR ... node has joined group");
+			}
+		}
+		sendOverlay(&msg.addr, NEIGHBORREPLY, &memberNode->addr, accept ? 1 : 0, NULL, 0);
+	} break;
+	case NEIGHBORREPLY: {
+		OverlayView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		if (neighborSent >= 0 && msg.addr == neighborAddr) {
+			neighborSent = -1;
+		}
+		if (msg.arg == 1) {
+			addNeighbor(&msg.addr);
+		}
+	} break;
+	case DISCONNECT: {
+		OverlayView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		dropNeighbor(&msg.addr);
+	} break;
+	case SHUFFLE: {
+		OverlayView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		forwardShuffle(&msg);
+	} break;
+	case SHUFFLEREPLY: {
+		OverlayView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		mergePassive(&msg.addr);
+		for (size_t i = 0; i < msg.n; ++i) {
+			mergePassive(&msg.addrs[i]);
+		}
+	} break;
+	case BROADCAST: {
+		BroadcastView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		deliverBroadcast(&msg);
+	} break;
+	case SYNCDIGEST: {
+		SyncDigestView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		answerSyncDigest(&msg);
+	} break;
+	case SYNCENTRIES: {
+		SyncEntriesView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		for (MemberListView::iterator it = msg.members.begin(); it != msg.members.end(); ++it) {
+			queueUpdate(&*it, &msg.addr);
+		}
+		if (msg.reply) {
+			sendSyncEntries(&msg.addr, msg.leaves, msg.n, false);
+		}
+	} break;
+	case IHAVE: {
+		IHaveView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		receiveIHave(&msg);
+	} break;
+	case GRAFT: {
+		GraftView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		receiveGraft(&msg);
+	} break;
+	case PRUNE: {
+		PruneView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		lazyPeers.insert(addressKey(&msg.addr));
+	} break;
+	case LEAVE: {
+		LeaveView msg;
+		if (!msg.parse(data, size)) {
+			return false;
+		}
+		departMember(&msg.addr, msg.incarnation, msg.heartbeat);
 	} break;
 	case TEST: {
-		TestPkg* p = (TestPkg*) data;
-		Address a = p->adr;
-		const char * adr = a.getAddress().c_str();
-		log->LOG(&memberNode->addr, adr);
+		TestView test;
+		if (!test.parse(data, size)) {
+			return false;
+		}
+		LOG_AT(log, LOG_DEBUG, LOG_INFO, &memberNode->addr, "%s", test.addr.getAddress().c_str());
 
 	} break;
 	default: {
-		char* s = data;
-//		int sz = size;
-#ifdef DEBUGLOG
-		log->LOG(&memberNode->addr, s);
-#endif
-
+		LOG_AT(log, LOG_NETWORK, LOG_ERROR, &memberNode->addr, "unknown message type %d", type);
+		return false;
 	}
 
 	}
-	/*
-#ifdef DEBUGLOG
-    static char s[1024];
-    sprintf(s, "recvCallBack: %s", data);
-    log->LOG(&memberNode->addr, s);
-#endif*/
     return true;
 }
 
 /**
- * FUNCTION NAME: nodeLoopOps
+ * FUNCTION NAME: sendPing
  *
- * DESCRIPTION: Check if any node hasn't responded within a timeout period and then delete
- * 				the nodes
- * 				Propagate your membership list
+ * DESCRIPTION: Send a PING or PONG carrying a random member entry, skipping over the receiver itself
  */
-void MP1Node::nodeLoopOps() {
+void MP1Node::sendPing(Address *to, enum MsgTypes type) {
+	char buf[PING_WIRE_MAX];
+	WireWriter w(buf, sizeof(buf));
+	w.putHeader(type);
+	w.putAddress(&memberNode->addr);
+	w.putByte(reportedJoinLoad());
 
-	/*
-	 * Your code goes here
-	 */
-#ifdef DEBUGLOG
-//        static char s[1024];
-//        sprintf(s, "nodeLoopOps() called, timeoutCntr = %d, pingCntr = %d, hbeat = %ld", memberNode->timeOutCounter, memberNode->pingCounter, memberNode->heartbeat);
-//        log->LOG(&memberNode->addr, s);
-#endif
+	MemberStatusInfo gossip;
+	bool hasGossip = pickGossip(to, &gossip);
+	w.putVarint(hasGossip ? 2 : 1);
 
-    // send PING message to random member
-	int neighbours = memberNode->nnb;
-	if (neighbours > 1) {
-		size_t node = rand() % memberNode->nnb;
-		size_t inode = rand() % memberNode->nnb;
-		while (inode == node) {
-			inode = rand() % memberNode->nnb;
-		}
-
-		MemberListEntry mle = memberNode->memberList[inode];
-		PingPkg pingPkg;
-		pingPkg.hdr.msgType = PING;
-		pingPkg.adr = memberNode->addr;
-		pingPkg.n = 1;
-		pingPkg.member.status = ALIVE;
-		MemberInfo info;
-		info.id = mle.id; info.port = mle.port; info.heartbeat = mle.heartbeat;
-		pingPkg.member.info = info;
-
-		if (memberNode->addr.addr[0]==1) {
-//			int dummy = 0;
-		}
-		ostringstream address;
-		address << memberNode->memberList[node].id << ":" << memberNode->memberList[node].port;
-		Address addr = Address(address.str());
-		emulNet->ENsend(&memberNode->addr, &addr, (char *) &pingPkg, sizeof(PingPkg));
+	// own entry first, its heartbeat refutes any suspicion about this node
+	MemberInfo info;
+	info.id = memberNode->addr.getId(); info.port = memberNode->addr.getPort(); info.heartbeat = memberNode->heartbeat;
+	info.incarnation = incarnation;
+	long prev = 0;
+	w.putByte(ALIVE);
+	putMemberInfo(&w, &info, &prev);
+	if (hasGossip) {
+		w.putByte(gossip.status);
+		putMemberInfo(&w, &gossip.info, &prev);
 	}
-	memberNode->timeOutCounter++;
-
-
+	sendMessage(to, buf, w.size(), SEND_PROBE);
+	if (type == PING) {
+		gossipCtl.pingSent(w.size());
+	}
+}
 
-    return;
+/**
+ * FUNCTION NAME: sendMessage
+ *
+ * DESCRIPTION: Send through the node's budget. Probes always go, updates wait
+ * 				behind earlier deferred ones and are deferred when over budget,
+ * 				bulk messages are trimmed.
+ *
+ * RETURNS:
+ * true if the message was handed to the network now
+ */
+bool MP1Node::sendMessage(Address *to, char *data, size_t size, enum SendClass cls) {
+	if ((cls != SEND_UPDATE || deferredSends.empty()) && budget.take(cls, size, par->getcurrtime())) {
+		emulNet->ENsend(&memberNode->addr, to, data, size);
+		return true;
+	}
+	if (cls == SEND_BULK) {
+		sendsTrimmed++;
+		emulNet->ENtrim(&memberNode->addr);
+		return false;
+	}
+	if (deferredSends.size() >= SEND_DEFER_MAX) {
+		deferredSends.erase(deferredSends.begin());
+		sendsTrimmed++;
+		emulNet->ENtrim(&memberNode->addr);
+	}
+	DeferredSend d;
+	d.to = *to;
+	d.data.assign(data, data + size);
+	deferredSends.push_back(d);
+	sendsDeferred++;
+	emulNet->ENdefer(&memberNode->addr);
+	return false;
 }
 
 /**
- * FUNCTION NAME: isNullAddress
+ * FUNCTION NAME: flushDeferred
  *
- * DESCRIPTION: Function checks if the address is NULL
+ * DESCRIPTION: Send the deferred updates the budget covers again, oldest first
  */
-int MP1Node::isNullAddress(Address *addr) {
-	return (memcmp(addr->addr, NULLADDR, 6) == 0 ? 1 : 0);
+void MP1Node::flushDeferred() {
+	size_t n = 0;
+	while (n < deferredSends.size()
+			&& budget.take(SEND_UPDATE, deferredSends[n].data.size(), par->getcurrtime())) {
+		emulNet->ENsend(&memberNode->addr, &deferredSends[n].to, &deferredSends[n].data[0], deferredSends[n].data.size());
+		n++;
+	}
+	deferredSends.erase(deferredSends.begin(), deferredSends.begin() + n);
 }
 
 /**
- * FUNCTION NAME: getJoinAddress
+ * FUNCTION NAME: pickGossip
+ *
+ * DESCRIPTION: Choose the entry to piggyback on a message to another node.
+ * 				Recent departures go first, then the receiver's own suspicion,
+ * 				and suspicions get half of the other slots, so all spread quickly.
  *
- * DESCRIPTION: Returns the Address of the coordinator
+ * RETURNS:
+ * false if there is nothing worth telling the receiver
  */
-Address MP1Node::getJoinAddress() {
-    Address joinaddr;
+bool MP1Node::pickGossip(Address *to, MemberStatusInfo *entry) {
+	for (size_t i = 0; i < departures.size(); ) {
+		if (departures[i].until < par->getcurrtime()) {
+			departures[i] = departures.back();
+			departures.pop_back();
+		} else {
+			++i;
+		}
+	}
+	if (!departures.empty()) {
+		Departure *d = &departures[rand() % departures.size()];
+		entry->status = LEFT;
+		entry->info.id = d->addr.getId();
+		entry->info.port = d->addr.getPort();
+		entry->info.heartbeat = d->heartbeat;
+		entry->info.incarnation = d->incarnation;
+		return true;
+	}
 
-    memset(&joinaddr, 0, sizeof(Address));
-    *(int *)(&joinaddr.addr) = 1;
-    *(short *)(&joinaddr.addr[4]) = 0;
+	// a suspected receiver is told first, so that it can refute
+	if (suspects.count(addressKey(to))) {
+		memberEntry(findMember(to), entry);
+		return true;
+	}
+	if (!suspects.empty() && rand() % 2 == 0) {
+		unordered_map<long long, Suspicion, AddressHash>::iterator it = suspects.begin();
+		advance(it, rand() % suspects.size());
+		Address addr = keyAddress(it->first);
+		memberEntry(findMember(&addr), entry);
+		return true;
+	}
 
-    return joinaddr;
+	size_t n = memberNode->memberList.size();
+	if (n == 0) {
+		return false;
+	}
+	size_t inode = rand() % n;
+	for (size_t tries = 0; tries < 2 && tries < n; ++tries) {
+		MemberListEntry *mle = &memberNode->memberList[(inode + tries) % n];
+		Address addr = Address(mle->id, mle->port);
+		if (addr == *to || addr == memberNode->addr) {
+			continue;
+		}
+		memberEntry(mle, entry);
+		return true;
+	}
+	return false;
 }
 
 /**
- * FUNCTION NAME: initMemberListTable
+ * FUNCTION NAME: answerJoins
  *
- * DESCRIPTION: Initialize the membership list
+ * DESCRIPTION: Add all joiners of this tick to the group and send each of them
+ * 				the same membership snapshot, built once
  */
-void MP1Node::initMemberListTable(Member *memberNode) {
-	memberNode->memberList.clear();
+void MP1Node::answerJoins() {
+	vector<Address> joiners;
+	for (size_t i = 0; i < pendingJoins.size(); ++i) {
+		JoinReqView *req = &pendingJoins[i];
+		// not in the group yet, the joiner fails over to another introducer
+		if (!memberNode->inGroup) {
+			continue;
+		}
+		if (find(joiners.begin(), joiners.end(), req->addr) != joiners.end()) {
+			continue;
+		}
+		if (joiners.size() >= JOIN_LOAD_MAX && req->redirects < JOIN_MAX_REDIRECTS && redirectJoin(&req->addr)) {
+			joinsRedirected++;
+			continue;
+		}
+		if (par->PARTIAL_VIEW) {
+			joinOverlay(&req->addr);
+		} else if (!inMemberList(&req->addr)) {
+			addMember(&req->addr, req->heartbeat);
+		}
+		joiners.push_back(req->addr);
+	}
+	pendingJoins.clear();
+	if (joiners.empty()) {
+		return;
+	}
+	joinsHandled += joiners.size();
+	joinLoad = joiners.size();
+	joinLoadTick = par->getcurrtime();
+	if (par->PARTIAL_VIEW) {
+		LOG_AT(log, LOG_MEMBERSHIP, LOG_TRACE, &memberNode->addr, "JOINREQ received from %d nodes ... send NEIGHBOR", (int)joiners.size());
+		return;
+	}
+
+	unsigned int id = buildJoinSnapshot();
+	for (size_t i = 0; i < joiners.size(); ++i) {
+		sendJoinFragments(id, &joiners[i]);
+	}
+
+	LOG_AT(log, LOG_MEMBERSHIP, LOG_TRACE, &memberNode->addr, "JOINREQ received from %d nodes ... send JOINREP", (int)joiners.size());
 }
 
 /**
- * FUNCTION NAME: printAddress
+ * FUNCTION NAME: redirectJoin
  *
- * DESCRIPTION: Print the Address
+ * DESCRIPTION: Point a joiner at the member with the lowest join load reported on its
+ * 				PINGs and PONGs, members at JOIN_LOAD_MAX or above are skipped.
+ * 				The scan starts at a random member, so ties spread the joiners.
+ *
+ * RETURNS:
+ * false if there is no member to redirect to
  */
-void MP1Node::printAddress(Address *addr)
-{
-    printf("%d.%d.%d.%d:%d \n",  addr->addr[0],addr->addr[1],addr->addr[2],
-                                                       addr->addr[3], *(short*)&addr->addr[4]) ;    
+bool MP1Node::redirectJoin(Address *joiner) {
+	size_t n = memberNode->memberList.size();
+	if (n == 0) {
+		return false;
+	}
+	size_t start = rand() % n;
+	MemberListEntry *best = NULL;
+	for (size_t k = 0; k < n; ++k) {
+		MemberListEntry *mle = &memberNode->memberList[(start + k) % n];
+		Address to = Address(mle->id, mle->port);
+		if (to == memberNode->addr || to == *joiner || mle->joinLoad >= JOIN_LOAD_MAX) {
+			continue;
+		}
+		if (best == NULL || mle->joinLoad < best->joinLoad) {
+			best = mle;
+		}
+	}
+	if (best == NULL) {
+		return false;
+	}
+	Address to = Address(best->id, best->port);
+	// count it right away so the rest of this tick's joiners spread over other members
+	best->joinLoad++;
+	char buf[WIRE_HDR_SIZE + WIRE_ADDR_MAX];
+	WireWriter w(buf, sizeof(buf));
+	w.putHeader(JOINREDIRECT);
+	w.putAddress(&to);
+	sendMessage(joiner, buf, w.size(), SEND_UPDATE);
+	return true;
 }
 
-char memberStatus(MemberStatus m) {
-	switch (m) {
-		case ALIVE: return 'A';
-		case SUSPECT: return 'S';
-		case DEAD: return 'D';
+/**
+ * FUNCTION NAME: reportedJoinLoad
+ *
+ * DESCRIPTION: Join load carried on this node's PINGs and PONGs
+ */
+unsigned char MP1Node::reportedJoinLoad() {
+	if (par->getcurrtime() - joinLoadTick >= JOIN_LOAD_TTL) {
+		return 0;
 	}
-	return '?';
+	return (unsigned char)min(joinLoad, 255);
 }
 
-bool MP1Node::inMemberList(Address* addr) {
-	IdPort idPort = IdPort(addr);
-	for (size_t i = 0; i < memberNode->memberList.size(); ++i) {
-		if (memberNode->memberList[i].id == idPort.getId() &&
-				memberNode->memberList[i].port == idPort.getPort()) {
-			return true;
-		}
+/**
+ * FUNCTION NAME: sendJoinReq
+ *
+ * DESCRIPTION: Send a JOINREQ and remember where and when for the failover timeout
+ */
+void MP1Node::sendJoinReq(Address *to) {
+	char buf[JOINREQ_WIRE_MAX];
+	WireWriter w(buf, sizeof(buf));
+	w.putHeader(JOINREQ);
+	w.putAddress(&memberNode->addr);
+	w.putZigzag(memberNode->heartbeat);
+	w.putByte(joinRedirects);
+
+	sendMessage(to, buf, w.size(), SEND_UPDATE);
+	joinAddr = *to;
+	joinSent = par->getcurrtime();
+}
+
+/**
+ * FUNCTION NAME: buildJoinSnapshot
+ *
+ * DESCRIPTION: Snapshot the membership list as JOINREP fragments
+ *
+ * RETURNS:
+ * snapshot id
+ */
+unsigned int MP1Node::buildJoinSnapshot() {
+	unsigned int id = nextSnapshot++;
+	JoinSnapshot &snap = snapshots[id];
+	snap.created = par->getcurrtime();
+	encodeJoinSnapshot(&memberNode->addr, memberNode->memberList, id, emulNet->ENmaxsize(), &snap.fragments);
+	return id;
+}
+
+/**
+ * FUNCTION NAME: sendJoinFragments
+ *
+ * DESCRIPTION: Stream all fragments of a snapshot to a joiner
+ */
+void MP1Node::sendJoinFragments(unsigned int id, Address *to) {
+	vector< vector<char> > &fragments = snapshots[id].fragments;
+	for (size_t i = 0; i < fragments.size(); ++i) {
+		sendMessage(to, &fragments[i][0], fragments[i].size(), SEND_BULK);
+	}
+}
+
+/**
+ * FUNCTION NAME: resendJoinFragments
+ *
+ * DESCRIPTION: Serve a JOINFRAGREQ, or a fresh snapshot if the requested one expired
+ */
+void MP1Node::resendJoinFragments(JoinFragReqView *req) {
+	map<unsigned int, JoinSnapshot>::iterator snap = snapshots.find(req->snapshot);
+	if (snap == snapshots.end()) {
+		sendJoinFragments(buildJoinSnapshot(), &req->addr);
+		return;
+	}
+	vector< vector<char> > &fragments = snap->second.fragments;
+	for (size_t i = 0; i < req->n; ++i) {
+		for (size_t f = req->ranges[i].first; f < fragments.size() && f - req->ranges[i].first < req->ranges[i].count; ++f) {
+			sendMessage(&req->addr, &fragments[f][0], fragments[f].size(), SEND_BULK);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: checkJoin
+ *
+ * DESCRIPTION: Request the missing JOINREP fragments once they are overdue
+ */
+void MP1Node::checkJoin() {
+	if (!memberNode->inGroup && par->getcurrtime() - joinSent >= JOIN_TIMEOUT) {
+		// no JOINREP at all, try the next introducer
+		joinAttempts++;
+		joinFailovers++;
+		joinRedirects = 0;
+		Address next = getJoinAddress();
+		LOG_AT(log, LOG_MEMBERSHIP, LOG_TRACE, &memberNode->addr, "JOINREQ timed out, failing over to %s", next.getAddress().c_str());
+		sendJoinReq(&next);
+		return;
+	}
+	if (joinMissing == 0 || par->getcurrtime() - joinProgress < JOINFRAG_TIMEOUT) {
+		return;
+	}
+
+	char buf[JOINFRAGREQ_WIRE_MAX];
+	FragRange ranges[JOINFRAG_MAX_RANGES];
+	size_t n = 0;
+	for (size_t f = 0; f < joinFragments.size() && n < JOINFRAG_MAX_RANGES; ++f) {
+		if (joinFragments[f]) {
+			continue;
+		}
+		if (n > 0 && ranges[n - 1].first + ranges[n - 1].count == f) {
+			ranges[n - 1].count++;
+		} else {
+			ranges[n].first = f;
+			ranges[n].count = 1;
+			n++;
+		}
+	}
+
+	WireWriter w(buf, sizeof(buf));
+	w.putHeader(JOINFRAGREQ);
+	w.putAddress(&memberNode->addr);
+	w.putVarint(joinSnapshot);
+	w.putVarint(n);
+	for (size_t i = 0; i < n; ++i) {
+		w.putVarint(ranges[i].first);
+		w.putVarint(ranges[i].count);
+	}
+	sendMessage(&joinFrom, buf, w.size(), SEND_UPDATE);
+	joinProgress = par->getcurrtime();
+}
+
+/**
+ * FUNCTION NAME: expireJoinSnapshots
+ *
+ * DESCRIPTION: Forget JOINREP snapshots nobody should still be assembling
+ */
+void MP1Node::expireJoinSnapshots() {
+	map<unsigned int, JoinSnapshot>::iterator it = snapshots.begin();
+	while (it != snapshots.end()) {
+		if (par->getcurrtime() - it->second.created > JOIN_SNAPSHOT_TTL) {
+			snapshots.erase(it++);
+		} else {
+			++it;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: nodeLoopOps
+ *
+ * DESCRIPTION: Check if any node hasn't responded within a timeout period and then delete
+ * 				the nodes
+ * 				Propagate your membership list
+ */
+void MP1Node::nodeLoopOps() {
+
+	/*
+	 * Your code goes here
+	 */
+
+	memberNode->heartbeat++;
+
+	// updates held back by the send budget go first
+	flushDeferred();
+
+#ifndef COROUTINES
+	checkProbes();
+#endif
+#if PHI_ACCRUAL
+	checkPhi();
+#endif
+	checkSuspects();
+	if (par->PARTIAL_VIEW) {
+		fillActiveView();
+		if (memberNode->heartbeat % SHUFFLE_PERIOD == 0) {
+			shuffleViews();
+		}
+#if PLUMTREE
+		checkMissing();
+		flushIHaves();
+#endif
+	}
+#if ANTIENTROPY_PERIOD > 0
+	// the active view is not meant to converge, only full membership lists are synced
+	else if (memberNode->heartbeat % ANTIENTROPY_PERIOD == 0) {
+		startSync();
+	}
+#endif
+
+    // send PING messages to the next members in probe order
+#if ADAPTIVE_GOSSIP
+	// partial views only know their neighbours, the passive view is a lower bound of N
+	gossipCtl.setGroupSize(memberNode->nnb + (par->PARTIAL_VIEW ? (int)view.passiveSize() : 0));
+	int fanout = gossipCtl.roundDue() ? min(gossipCtl.getFanout(), (int)probes.size()) : 0;
+	if (gossipCtl.takeChanged()) {
+		LOG_AT(log, LOG_GOSSIP, LOG_INFO, &memberNode->addr, "#STATSLOG# gossip fanout %d interval %d for N %d ack loss %.3f",
+				gossipCtl.getFanout(), gossipCtl.getInterval(), gossipCtl.getGroupSize(), gossipCtl.getAckLoss());
+	}
+#else
+	int fanout = 1;
+#endif
+	Address addr;
+	for (int f = 0; f < fanout && memberNode->nnb > 0 && probes.nextTarget(&addr); ++f) {
+		sendPing(&addr, PING);
+#ifdef COROUTINES
+		if (!awaitingAck(&addr)) {
+			probeTask(addr);
+		}
+#else
+		bool pending = false;
+		for (size_t i = 0; i < pendingProbes.size(); ++i) {
+			pending = pending || pendingProbes[i].addr == addr;
+		}
+		if (!pending) {
+			PendingProbe probe;
+			probe.addr = addr;
+			probe.sent = par->getcurrtime();
+			pendingProbes.push_back(probe);
+		}
+#endif
+	}
+	memberNode->timeOutCounter++;
+
+    return;
+}
+
+/**
+ * FUNCTION NAME: isNullAddress
+ *
+ * DESCRIPTION: Function checks if the address is NULL
+ */
+int MP1Node::isNullAddress(Address *addr) {
+	return addr->isNull() ? 1 : 0;
+}
+
+/**
+ * FUNCTION NAME: getJoinAddress
+ *
+ * DESCRIPTION: Returns the Address of the introducer to join through
+ */
+Address MP1Node::getJoinAddress() {
+    Address joinaddr = par->getIntroducer(0);
+
+    // the first introducer boots the group
+    if (memberNode->addr == joinaddr) {
+    	return joinaddr;
+    }
+
+    // spread joiners over the introducers by a hash of their id, moving on with every failover
+    unsigned int start = ((unsigned int)memberNode->addr.getId() * 2654435761u) % par->INTRODUCERS;
+    for (int i = 0; i < par->INTRODUCERS; ++i) {
+    	joinaddr = par->getIntroducer((start + joinAttempts + i) % par->INTRODUCERS);
+    	if (!(joinaddr == memberNode->addr)) {
+    		break;
+    	}
+    }
+
+    return joinaddr;
+}
+
+/**
+ * FUNCTION NAME: initMemberListTable
+ *
+ * DESCRIPTION: Initialize the membership list
+ */
+void MP1Node::initMemberListTable(Member *memberNode) {
+	memberNode->memberList.clear();
+}
+
+/**
+ * FUNCTION NAME: printAddress
+ *
+ * DESCRIPTION: Print the Address
+ */
+void MP1Node::printAddress(Address *addr)
+{
+    printf("%d.%d.%d.%d:%d \n", addr->getByte(0), addr->getByte(1), addr->getByte(2), addr->getByte(3), addr->getPort());
+}
+
+bool MP1Node::inMemberList(Address* addr) {
+	return findMember(addr) != NULL;
+}
+
+/**
+ * FUNCTION NAME: findMember
+ *
+ * DESCRIPTION: Membership list entry of an address, NULL if it is not a member
+ */
+MemberListEntry *MP1Node::findMember(Address *addr) {
+	unordered_map<long long, size_t, AddressHash>::iterator it = memberIndex.find(addressKey(addr));
+	if (it == memberIndex.end()) {
+		return NULL;
+	}
+	return &memberNode->memberList[it->second];
+}
+
+/**
+ * FUNCTION NAME: addMember
+ *
+ * DESCRIPTION: Add a new member to the membership list and to the probe order
+ */
+void MP1Node::addMember(Address *addr, long heartbeat) {
+	long long key = addressKey(addr);
+	memberIndex[key] = memberNode->memberList.size();
+	memberNode->memberList.push_back(MemberListEntry(addr->getId(), addr->getPort(), heartbeat, par->getcurrtime()));
+	memberNode->memberList.back().arrivals.heartbeat(par->getcurrtime());
+	removed.erase(key);
+	memberNode->nnb++;
+	if (!(*addr == memberNode->addr)) {
+		probes.add(addr);
+	}
+	// partial views log the group's joins as their BROADCASTs arrive instead
+	if (!par->PARTIAL_VIEW) {
+		log->logNodeAdd(&memberNode->addr, addr);
+	}
+}
+
+/**
+ * FUNCTION NAME: removeMember
+ *
+ * DESCRIPTION: Drop a failed member, remembering its tombstone so stale gossip cannot bring it back
+ */
+void MP1Node::removeMember(Address *addr) {
+	Tombstone tomb;
+	if (!unlinkMember(addr, &tomb)) {
+		return;
+	}
+	removals++;
+	if (par->PARTIAL_VIEW) {
+		// tell the rest of the group, who only hear about it through this node's neighbours
+		broadcast(DEAD, addr);
+	} else {
+		log->logNodeRemove(&memberNode->addr, addr);
+	}
+	removed[addressKey(addr)] = tomb;
+}
+
+/**
+ * FUNCTION NAME: departMember
+ *
+ * DESCRIPTION: Drop a member that left the group, and gossip its departure on
+ */
+void MP1Node::departMember(Address *addr, unsigned int incarnation, long heartbeat) {
+	Tombstone tomb;
+	if (!unlinkMember(addr, &tomb)) {
+		return;
+	}
+	if (par->PARTIAL_VIEW) {
+		view.removePassive(addr);
+	}
+	leavesReceived++;
+	log->logNodeRemove(&memberNode->addr, addr);
+	tomb.heartbeat = max(tomb.heartbeat, heartbeat);
+	tomb.incarnation = max(tomb.incarnation, incarnation);
+	removed[addressKey(addr)] = tomb;
+
+	Departure d;
+	d.addr = *addr;
+	d.heartbeat = heartbeat;
+	d.incarnation = incarnation;
+	d.until = par->getcurrtime() + LEAVE_GOSSIP_TICKS;
+	departures.push_back(d);
+}
+
+/**
+ * FUNCTION NAME: unlinkMember
+ *
+ * DESCRIPTION: Drop a member from the membership list, the probe order and the failure detector
+ *
+ * RETURNS:
+ * false if it was not a member
+ */
+bool MP1Node::unlinkMember(Address *addr, Tombstone *tomb) {
+	long long key = addressKey(addr);
+	unordered_map<long long, size_t, AddressHash>::iterator it = memberIndex.find(key);
+	if (it == memberIndex.end()) {
+		return false;
+	}
+	vector<MemberListEntry> &list = memberNode->memberList;
+	size_t i = it->second;
+	tomb->heartbeat = list[i].heartbeat;
+	tomb->incarnation = list[i].incarnation;
+	tomb->time = par->getcurrtime();
+	memberIndex.erase(it);
+	if (i != list.size() - 1) {
+		list[i] = list.back();
+		memberIndex[memberKey(list[i].id, list[i].port)] = i;
+	}
+	list.pop_back();
+	memberNode->nnb--;
+
+	probes.remove(addr);
+	suspects.erase(key);
+	lazyPeers.erase(key);
+	for (size_t p = 0; p < pendingProbes.size(); ++p) {
+		if (pendingProbes[p].addr == *addr) {
+			pendingProbes.erase(pendingProbes.begin() + p);
+			break;
+		}
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: memberEntry
+ *
+ * DESCRIPTION: The entry this node gossips about a member
+ */
+void MP1Node::memberEntry(MemberListEntry *mle, MemberStatusInfo *entry) {
+	entry->status = suspects.count(memberKey(mle->id, mle->port)) ? SUSPECT : ALIVE;
+	entry->info.id = mle->id;
+	entry->info.port = mle->port;
+	entry->info.heartbeat = mle->heartbeat;
+	entry->info.incarnation = mle->incarnation;
+}
+
+/**
+ * FUNCTION NAME: applyGossip
+ *
+ * DESCRIPTION: Merge a received member entry.
+ * 				(incarnation, status) orders the updates, see compareStatus.
+ * 				A suspected member ends the suspicion by gossiping ALIVE at a
+ * 				higher incarnation as soon as it hears of it, instead of
+ * 				waiting for a newer heartbeat to spread. LEFT removes the
+ * 				member at once.
+ */
+void MP1Node::applyGossip(const MemberStatusInfo *entry, Address *from) {
+	Address addr = Address(entry->info.id, entry->info.port);
+	if (addr == memberNode->addr) {
+		// refute: our own entry goes out with every message, now beating the suspicion
+		if (entry->status != ALIVE && entry->info.incarnation >= incarnation) {
+			incarnation = entry->info.incarnation + 1;
+			health.refuted();
+		}
+		return;
+	}
+
+	long long key = memberKey(entry->info.id, entry->info.port);
+	MemberListEntry *mle = findMember(&addr);
+	if (mle == NULL) {
+		unordered_map<long long, Tombstone, AddressHash>::iterator dead = removed.find(key);
+		if (entry->status == LEFT) {
+			// keep stale ALIVE gossip from bringing it back
+			Tombstone tomb = { entry->info.heartbeat, entry->info.incarnation, par->getcurrtime() };
+			if (dead != removed.end()) {
+				tomb.heartbeat = max(tomb.heartbeat, dead->second.heartbeat);
+				tomb.incarnation = max(tomb.incarnation, dead->second.incarnation);
+			}
+			removed[key] = tomb;
+			if (par->PARTIAL_VIEW) {
+				view.removePassive(&addr);
+			}
+			return;
+		}
+		if (entry->status != ALIVE) {
+			return;
+		}
+		// a peer may have heard a heartbeat or two more before the crash: while the tombstone
+		// is fresh only the member refuting at a higher incarnation brings it back
+		if (dead != removed.end() && entry->info.incarnation <= dead->second.incarnation &&
+				par->getcurrtime() - dead->second.time < TOMBSTONE_TTL * protocolPeriod()) {
+			dead->second.heartbeat = max(dead->second.heartbeat, entry->info.heartbeat);
+			return;
+		}
+		// a removed member comes back with a newer heartbeat, or by refuting at a higher incarnation
+		if (dead == removed.end() || entry->info.heartbeat > dead->second.heartbeat ||
+				entry->info.incarnation > dead->second.incarnation) {
+			if (par->PARTIAL_VIEW) {
+				mergePassive(&addr);
+			} else {
+				addMember(&addr, entry->info.heartbeat);
+				memberNode->memberList.back().incarnation = entry->info.incarnation;
+			}
+		}
+		return;
+	}
+
+	MemberStatusInfo cur;
+	memberEntry(mle, &cur);
+	int order = compareStatus(entry, &cur);
+	if (entry->status == ALIVE && entry->info.heartbeat > mle->heartbeat) {
+		mle->heartbeat = entry->info.heartbeat;
+		mle->timestamp = par->getcurrtime();
+		mle->arrivals.heartbeat(par->getcurrtime());
+	}
+	if (order < 0) {
+		return;
+	}
+	switch (entry->status) {
+	case ALIVE:
+		// a higher incarnation, or a newer heartbeat than the suspicion's
+		if (order > 0) {
+			mle->incarnation = entry->info.incarnation;
+			if (suspects.erase(key) > 0) {
+				refutedSuspicions++;
+			}
+		}
+		break;
+	case SUSPECT:
+	case DEAD:
+		// a suspicion of an older incarnation does not count towards this one
+		if (entry->info.incarnation > mle->incarnation) {
+			mle->incarnation = entry->info.incarnation;
+			suspects.erase(key);
+		}
+		// DEAD: removed elsewhere, let the local suspicion timeout decide
+		suspect(&addr, from);
+		break;
+	case LEFT:
+		departMember(&addr, entry->info.incarnation, entry->info.heartbeat);
+		break;
+	}
+}
+
+/**
+ * FUNCTION NAME: suspect
+ *
+ * DESCRIPTION: Start suspecting a member at its current incarnation, or count
+ * 				another node confirming the suspicion
+ */
+void MP1Node::suspect(Address *addr, Address *from) {
+	long long key = addressKey(addr);
+	unordered_map<long long, Suspicion, AddressHash>::iterator it = suspects.find(key);
+	if (it == suspects.end()) {
+		Suspicion s;
+		s.start = par->getcurrtime();
+		s.n = 0;
+		it = suspects.insert(make_pair(key, s)).first;
+		suspicions++;
+		if (LOG_ENABLED(log, LOG_MEMBERSHIP, LOG_TRACE)) {
+			log->logNodeSuspect(&memberNode->addr, addr);
+		}
+	}
+
+	Suspicion *s = &it->second;
+	if (*from == memberNode->addr || s->n >= SUSPICION_K) {
+		return;
+	}
+	int confirmer = from->getId();
+	for (int i = 0; i < s->n; ++i) {
+		if (s->confirmers[i] == confirmer) {
+			return;
+		}
+	}
+	s->confirmers[s->n++] = confirmer;
+}
+
+/**
+ * FUNCTION NAME: checkProbes
+ *
+ * DESCRIPTION: Suspect members that did not answer a probe in time
+ */
+void MP1Node::checkProbes() {
+#if LIFEGUARD
+	int timeout = health.scale(PROBE_TIMEOUT);
+#else
+	int timeout = PROBE_TIMEOUT;
+#endif
+	size_t i = 0;
+	while (i < pendingProbes.size()) {
+		if (par->getcurrtime() - pendingProbes[i].sent <= timeout) {
+			++i;
+			continue;
+		}
+		Address addr = pendingProbes[i].addr;
+		pendingProbes.erase(pendingProbes.begin() + i);
+		probeMissed(&addr);
+	}
+}
+
+/**
+ * FUNCTION NAME: probeMissed
+ *
+ * DESCRIPTION: A probe of a member timed out
+ */
+void MP1Node::probeMissed(Address *addr) {
+	health.probeMissed();
+	gossipCtl.ackMissed();
+#if !PHI_ACCRUAL
+	MemberListEntry *mle = findMember(addr);
+	if (mle != NULL) {
+		suspect(addr, &memberNode->addr);
+	}
+#endif
+}
+
+#ifdef COROUTINES
+/**
+ * FUNCTION NAME: setScheduler
+ *
+ * DESCRIPTION: Scheduler resuming the coroutines of this node
+ */
+void MP1Node::setScheduler(Scheduler *sched) {
+	this->sched = sched;
+}
+
+/**
+ * FUNCTION NAME: receiveTask
+ *
+ * DESCRIPTION: Handle messages whenever some arrived
+ */
+NodeTask MP1Node::receiveTask() {
+	for (;;) {
+		co_await MessageAwait(this);
+		if (memberNode->bFailed) {
+			co_return;
+		}
+		checkMessages();
+	}
+}
+
+/**
+ * FUNCTION NAME: tickTask
+ *
+ * DESCRIPTION: Run the periodic duties of nodeLoop once per tick, after the messages of the tick
+ */
+NodeTask MP1Node::tickTask() {
+	for (;;) {
+		co_await TimerAwait(sched, 1);
+		if (memberNode->bFailed) {
+			co_return;
+		}
+		checkJoin();
+		expireJoinSnapshots();
+		if (memberNode->inGroup) {
+			nodeLoopOps();
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: probeTask
+ *
+ * DESCRIPTION: Wait for the PONG of a probed member, and suspect it if none comes in time.
+ * 				Like checkProbes, the probe expires once more than the timeout has passed.
+ */
+NodeTask MP1Node::probeTask(Address addr) {
+#if LIFEGUARD
+	int timeout = health.scale(PROBE_TIMEOUT);
+#else
+	int timeout = PROBE_TIMEOUT;
+#endif
+	if (co_await AckAwait(this, addr, timeout + 1)) {
+		health.probeAcked();
+		gossipCtl.ackReceived();
+		co_return;
+	}
+	// removed meanwhile, or this node crashed
+	if (memberNode->bFailed || findMember(&addr) == NULL) {
+		co_return;
+	}
+	probeMissed(&addr);
+}
+
+/**
+ * FUNCTION NAME: waitMessages
+ *
+ * DESCRIPTION: Park the receiver until notifyMessages finds messages
+ */
+void MP1Node::waitMessages(std::coroutine_handle<> handle) {
+	msgWaiter = handle;
+}
+
+/**
+ * FUNCTION NAME: notifyMessages
+ *
+ * DESCRIPTION: Wake the receiver if recvLoop queued messages for it
+ */
+void MP1Node::notifyMessages() {
+	if (msgWaiter && memberNode->mp1q.size() > 0) {
+		sched->wake(msgWaiter);
+		msgWaiter = nullptr;
+	}
+}
+
+/**
+ * FUNCTION NAME: waitAck
+ *
+ * DESCRIPTION: Park a probe until the PONG of addr or ticks ticks, whichever comes first
+ */
+void MP1Node::waitAck(Address *addr, int ticks, std::coroutine_handle<> handle, bool *acked) {
+	AckWait wait;
+	wait.addr = *addr;
+	wait.deadline = sched->addTimer(ticks, handle);
+	wait.handle = handle;
+	wait.acked = acked;
+	ackWaits.push_back(wait);
+}
+
+/**
+ * FUNCTION NAME: forgetAck
+ *
+ * DESCRIPTION: Drop the wait of a probe that timed out
+ */
+void MP1Node::forgetAck(std::coroutine_handle<> handle) {
+	for (size_t i = 0; i < ackWaits.size(); ++i) {
+		if (ackWaits[i].handle == handle) {
+			ackWaits.erase(ackWaits.begin() + i);
+			return;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: ackProbe
+ *
+ * DESCRIPTION: Wake the probe waiting for a PONG from addr, cancelling its timeout
+ *
+ * RETURNS:
+ * false if no probe was waiting for it
+ */
+bool MP1Node::ackProbe(Address *addr) {
+	for (size_t i = 0; i < ackWaits.size(); ++i) {
+		if (ackWaits[i].addr == *addr) {
+			sched->cancelTimer(ackWaits[i].deadline, ackWaits[i].handle);
+			*ackWaits[i].acked = true;
+			sched->wake(ackWaits[i].handle);
+			ackWaits.erase(ackWaits.begin() + i);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * FUNCTION NAME: awaitingAck
+ *
+ * DESCRIPTION: true if a probe of addr is still waiting for its PONG
+ */
+bool MP1Node::awaitingAck(Address *addr) {
+	for (size_t i = 0; i < ackWaits.size(); ++i) {
+		if (ackWaits[i].addr == *addr) {
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+/**
+ * FUNCTION NAME: checkPhi
+ *
+ * DESCRIPTION: Suspect members whose heartbeats are overdue by more than PHI_THRESHOLD
+ */
+void MP1Node::checkPhi() {
+	for (size_t i = 0; i < memberNode->memberList.size(); ++i) {
+		MemberListEntry *mle = &memberNode->memberList[i];
+		if (mle->arrivals.phi(par->getcurrtime()) <= PHI_THRESHOLD ||
+				suspects.count(memberKey(mle->id, mle->port))) {
+			continue;
+		}
+		Address addr = Address(mle->id, mle->port);
+		if (!(addr == memberNode->addr)) {
+			suspect(&addr, &memberNode->addr);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: checkSuspects
+ *
+ * DESCRIPTION: Remove members whose suspicion timed out
+ */
+void MP1Node::checkSuspects() {
+	vector<Address> expired;
+	for (unordered_map<long long, Suspicion, AddressHash>::iterator it = suspects.begin(); it != suspects.end(); ++it) {
+		if (par->getcurrtime() - it->second.start >= suspicionTimeout(&it->second)) {
+			expired.push_back(keyAddress(it->first));
+		}
+	}
+	for (size_t i = 0; i < expired.size(); ++i) {
+		removeMember(&expired[i]);
+	}
+}
+
+/**
+ * FUNCTION NAME: protocolPeriod
+ *
+ * DESCRIPTION: Ticks between PING rounds, the unit of the suspicion and tombstone timeouts
+ */
+int MP1Node::protocolPeriod() {
+#if ADAPTIVE_GOSSIP
+	return gossipCtl.getInterval();
+#else
+	return 1;
+#endif
+}
+
+/**
+ * FUNCTION NAME: suspicionTimeout
+ *
+ * DESCRIPTION: Ticks a suspicion lasts before the member is removed.
+ * 				A suspicion starts at TREMOVE and moves towards TFAIL as independent
+ * 				confirmations arrive. Lifeguard also scales both by the local health.
+ * 				The bounds count protocol periods, so they stretch with the
+ * 				gossip interval: a refutation spreads once per round.
+ */
+int MP1Node::suspicionTimeout(Suspicion *s) {
+	int period = protocolPeriod();
+#if LIFEGUARD
+	double lo = health.scale(TFAIL * period);
+	double hi = health.scale(TREMOVE * period);
+#else
+	double lo = TFAIL * period;
+	double hi = TREMOVE * period;
+#endif
+	double timeout = hi - (hi - lo) * ::log(s->n + 1.0) / ::log(SUSPICION_K + 1.0);
+	return (int)ceil(max(lo, timeout));
+}
+
+/**
+ * FUNCTION NAME: sendOverlay
+ *
+ * DESCRIPTION: Send one of the messages maintaining the partial views
+ */
+void MP1Node::sendOverlay(Address *to, enum MsgTypes type, Address *subject, unsigned int arg, Address *addrs, size_t n) {
+	char buf[OVERLAY_WIRE_MAX];
+	WireWriter w(buf, sizeof(buf));
+	n = min(n, (size_t)OVERLAY_MAX_ADDRS);
+	w.putHeader(type);
+	w.putAddress(&memberNode->addr);
+	w.putAddress(subject);
+	w.putVarint(arg);
+	w.putVarint(n);
+	for (size_t i = 0; i < n; ++i) {
+		w.putAddress(&addrs[i]);
+	}
+	sendMessage(to, buf, w.size(), SEND_UPDATE);
+}
+
+/**
+ * FUNCTION NAME: joinOverlay
+ *
+ * DESCRIPTION: Take a joiner into the active view and start its FORWARDJOIN
+ * 				random walks from every other neighbour
+ */
+void MP1Node::joinOverlay(Address *joiner) {
+	addNeighbor(joiner);
+	sendOverlay(joiner, NEIGHBOR, &memberNode->addr, 1, NULL, 0);
+	for (size_t i = 0; i < memberNode->memberList.size(); ++i) {
+		MemberListEntry *mle = &memberNode->memberList[i];
+		Address to = Address(mle->id, mle->port);
+		if (!(to == *joiner)) {
+			sendOverlay(&to, FORWARDJOIN, joiner, ACTIVE_RWL, NULL, 0);
+		}
+	}
+	broadcast(ALIVE, joiner);
+}
+
+/**
+ * FUNCTION NAME: forwardJoin
+ *
+ * DESCRIPTION: One hop of a FORWARDJOIN random walk. The walk ends by making the joiner
+ * 				an active neighbour; on its way it leaves the joiner in one passive view.
+ */
+void MP1Node::forwardJoin(OverlayView *msg) {
+	if (msg->subject == memberNode->addr || inMemberList(&msg->subject)) {
+		return;
+	}
+	Address next;
+	if (msg->arg > 0 && memberNode->nnb > 1 && randomNeighbor(&next, &msg->addr, &msg->subject)) {
+		if (msg->arg == PASSIVE_RWL) {
+			mergePassive(&msg->subject);
+		}
+		sendOverlay(&next, FORWARDJOIN, &msg->subject, msg->arg - 1, NULL, 0);
+		return;
+	}
+	addNeighbor(&msg->subject);
+	sendOverlay(&msg->subject, NEIGHBOR, &memberNode->addr, 1, NULL, 0);
+}
+
+/**
+ * FUNCTION NAME: addNeighbor
+ *
+ * DESCRIPTION: Move a node into the active view, disconnecting a random neighbour if it is full
+ */
+void MP1Node::addNeighbor(Address *addr) {
+	if (*addr == memberNode->addr || inMemberList(addr)) {
+		return;
+	}
+	view.removePassive(addr);
+	if (memberNode->nnb >= (int)view.getActiveMax()) {
+		MemberListEntry *mle = &memberNode->memberList[rand() % memberNode->memberList.size()];
+		Address victim = Address(mle->id, mle->port);
+		sendOverlay(&victim, DISCONNECT, &memberNode->addr, 0, NULL, 0);
+		dropNeighbor(&victim);
+	}
+	addMember(addr, 0);
+}
+
+/**
+ * FUNCTION NAME: dropNeighbor
+ *
+ * DESCRIPTION: Move an active neighbour that disconnected back to the passive view
+ */
+void MP1Node::dropNeighbor(Address *addr) {
+	Tombstone tomb;
+	if (unlinkMember(addr, &tomb)) {
+		view.addPassive(addr);
+	}
+}
+
+/**
+ * FUNCTION NAME: randomNeighbor
+ *
+ * DESCRIPTION: Pick a random active neighbour other than except1 and except2
+ *
+ * RETURNS:
+ * false if there is none
+ */
+bool MP1Node::randomNeighbor(Address *addr, Address *except1, Address *except2) {
+	size_t n = memberNode->memberList.size();
+	if (n == 0) {
+		return false;
+	}
+	size_t start = rand() % n;
+	for (size_t i = 0; i < n; ++i) {
+		MemberListEntry *mle = &memberNode->memberList[(start + i) % n];
+		*addr = Address(mle->id, mle->port);
+		if ((except1 == NULL || !(*addr == *except1)) && (except2 == NULL || !(*addr == *except2))) {
+			return true;
+		}
 	}
 	return false;
 }
+
+/**
+ * FUNCTION NAME: mergePassive
+ *
+ * DESCRIPTION: Learn about a node for the passive view
+ */
+void MP1Node::mergePassive(Address *addr) {
+	if (!(*addr == memberNode->addr) && !inMemberList(addr)) {
+		view.addPassive(addr);
+	}
+}
+
+/**
+ * FUNCTION NAME: fillActiveView
+ *
+ * DESCRIPTION: Ask a random passive view member to become a neighbour while the active
+ * 				view is not full, one request at a time. Unanswered requests drop the
+ * 				member from the passive view.
+ */
+void MP1Node::fillActiveView() {
+	if (neighborSent >= 0 && par->getcurrtime() - neighborSent > PROBE_TIMEOUT) {
+		view.removePassive(&neighborAddr);
+		neighborSent = -1;
+	}
+	if (neighborSent >= 0 || memberNode->nnb >= (int)view.getActiveMax() || !view.randomPassive(&neighborAddr)) {
+		return;
+	}
+	sendOverlay(&neighborAddr, NEIGHBOR, &memberNode->addr, memberNode->nnb == 0 ? 1 : 0, NULL, 0);
+	neighborSent = par->getcurrtime();
+}
+
+/**
+ * FUNCTION NAME: shuffleViews
+ *
+ * DESCRIPTION: Start a SHUFFLE random walk carrying a sample of both views
+ */
+void MP1Node::shuffleViews() {
+	Address to;
+	if (!randomNeighbor(&to, NULL, NULL)) {
+		return;
+	}
+	vector<Address> sample;
+	size_t n = memberNode->memberList.size();
+	size_t start = rand() % n;
+	for (size_t i = 0; i < n && sample.size() < SHUFFLE_ACTIVE; ++i) {
+		MemberListEntry *mle = &memberNode->memberList[(start + i) % n];
+		Address addr = Address(mle->id, mle->port);
+		if (!(addr == to)) {
+			sample.push_back(addr);
+		}
+	}
+	view.samplePassive(SHUFFLE_PASSIVE, &sample);
+	sendOverlay(&to, SHUFFLE, &memberNode->addr, SHUFFLE_RWL, sample.empty() ? NULL : &sample[0], sample.size());
+	shuffles++;
+}
+
+/**
+ * FUNCTION NAME: forwardShuffle
+ *
+ * DESCRIPTION: One hop of a SHUFFLE random walk. The last hop answers the origin with a
+ * 				passive view sample of the same size and keeps the received one.
+ */
+void MP1Node::forwardShuffle(OverlayView *msg) {
+	if (msg->subject == memberNode->addr) {
+		return;
+	}
+	Address next;
+	if (msg->arg > 0 && memberNode->nnb > 1 && randomNeighbor(&next, &msg->addr, &msg->subject)) {
+		char buf[OVERLAY_WIRE_MAX];
+		WireWriter w(buf, sizeof(buf));
+		w.putHeader(SHUFFLE);
+		w.putAddress(&memberNode->addr);
+		w.putAddress(&msg->subject);
+		w.putVarint(msg->arg - 1);
+		w.putVarint(msg->n);
+		for (size_t i = 0; i < msg->n; ++i) {
+			w.putAddress(&msg->addrs[i]);
+		}
+		sendMessage(&next, buf, w.size(), SEND_UPDATE);
+		return;
+	}
+
+	vector<Address> reply;
+	view.samplePassive(msg->n + 1, &reply);
+	sendOverlay(&msg->subject, SHUFFLEREPLY, &memberNode->addr, 0, reply.empty() ? NULL : &reply[0], reply.size());
+	mergePassive(&msg->subject);
+	for (size_t i = 0; i < msg->n; ++i) {
+		mergePassive(&msg->addrs[i]);
+	}
+}
+
+/**
+ * FUNCTION NAME: broadcast
+ *
+ * DESCRIPTION: Flood a membership event to the whole group over the active views
+ */
+void MP1Node::broadcast(MemberStatus event, Address *subject) {
+	BroadcastView msg;
+	msg.addr = memberNode->addr;
+	msg.origin = memberNode->addr;
+	msg.seq = broadcastSeq++;
+	msg.event = event;
+	msg.subject = *subject;
+	deliverBroadcast(&msg);
+}
+
+/**
+ * FUNCTION NAME: deliverBroadcast
+ *
+ * DESCRIPTION: Log a membership event the first time it arrives and pass it on to
+ * 				every active neighbour but the one it came from. The active views form
+ * 				a connected overlay, so the event reaches every member.
+ * 				With PLUMTREE only eager peers get the event itself and lazy ones an
+ * 				IHAVE; the link of every redundant copy is pruned, leaving a spanning
+ * 				tree of eager links.
+ */
+void MP1Node::deliverBroadcast(BroadcastView *msg) {
+	bool local = msg->addr == memberNode->addr;
+	if (!markSeen(msg)) {
+		broadcastDuplicates++;
+#if PLUMTREE
+		if (!local && inMemberList(&msg->addr) && lazyPeers.insert(addressKey(&msg->addr)).second) {
+			char buf[WIRE_HDR_SIZE + WIRE_ADDR_MAX];
+			WireWriter w(buf, sizeof(buf));
+			w.putHeader(PRUNE);
+			w.putAddress(&memberNode->addr);
+			sendMessage(&msg->addr, buf, w.size(), SEND_UPDATE);
+			prunes++;
+		}
+#endif
+		return;
+	}
+#if PLUMTREE
+	missingEvents.erase(eventKey(&msg->origin, msg->seq));
+	if (!local) {
+		lazyPeers.erase(addressKey(&msg->addr));
+	}
+#endif
+	if (!(msg->subject == memberNode->addr)) {
+		long long key = addressKey(&msg->subject);
+		if (msg->event == ALIVE) {
+			// a rejoined node can fail again, its next DEAD must not be taken for a duplicate
+			removed.erase(key);
+			log->logNodeAdd(&memberNode->addr, &msg->subject);
+		} else if (removed.count(key)) {
+			// every neighbour of a failed node reports it, one flood is enough
+			return;
+		} else {
+			Tombstone tomb = Tombstone();
+			tomb.time = par->getcurrtime();
+			unlinkMember(&msg->subject, &tomb);
+			removed[key] = tomb;
+			view.removePassive(&msg->subject);
+			log->logNodeRemove(&memberNode->addr, &msg->subject);
+		}
+	}
+
+	for (size_t i = 0; i < memberNode->memberList.size(); ++i) {
+		MemberListEntry *mle = &memberNode->memberList[i];
+		Address to = Address(mle->id, mle->port);
+		if (to == msg->addr || to == msg->subject) {
+			continue;
+		}
+#if PLUMTREE
+		if (lazyPeers.count(memberKey(mle->id, mle->port))) {
+			PendingIHave ihave;
+			ihave.to = to;
+			ihave.origin = msg->origin;
+			ihave.seq = msg->seq;
+			lazyQueue.push_back(ihave);
+			continue;
+		}
+#endif
+		sendBroadcast(&to, msg);
+	}
+	broadcasts++;
+}
+
+/**
+ * FUNCTION NAME: sendBroadcast
+ *
+ * DESCRIPTION: Send a BROADCAST on behalf of its origin
+ */
+void MP1Node::sendBroadcast(Address *to, BroadcastView *msg) {
+	char buf[BROADCAST_WIRE_MAX];
+	WireWriter w(buf, sizeof(buf));
+	w.putHeader(BROADCAST);
+	w.putAddress(&memberNode->addr);
+	w.putAddress(&msg->origin);
+	w.putVarint(msg->seq);
+	w.putByte(msg->event);
+	w.putAddress(&msg->subject);
+	sendMessage(to, buf, w.size(), SEND_UPDATE);
+}
+
+/**
+ * FUNCTION NAME: markSeen
+ *
+ * DESCRIPTION: Remember a BROADCAST to serve GRAFTs, forgetting the oldest beyond BROADCAST_SEEN_MAX
+ *
+ * RETURNS:
+ * false if it was seen before
+ */
+bool MP1Node::markSeen(BroadcastView *msg) {
+	unsigned long long key = eventKey(&msg->origin, msg->seq);
+	if (!seenEvents.insert(make_pair(key, *msg)).second) {
+		return false;
+	}
+	seenOrder.push(key);
+	if (seenOrder.size() > BROADCAST_SEEN_MAX) {
+		seenEvents.erase(seenOrder.front());
+		seenOrder.pop();
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: receiveIHave
+ *
+ * DESCRIPTION: Note the announced BROADCASTs that did not arrive yet, and who has them
+ */
+void MP1Node::receiveIHave(IHaveView *msg) {
+	for (size_t i = 0; i < msg->n; ++i) {
+		unsigned long long key = eventKey(&msg->origins[i], msg->seqs[i]);
+		if (seenEvents.count(key)) {
+			continue;
+		}
+		map<unsigned long long, MissingEvent>::iterator it = missingEvents.find(key);
+		if (it == missingEvents.end()) {
+			MissingEvent missing;
+			missing.origin = msg->origins[i];
+			missing.seq = msg->seqs[i];
+			missing.deadline = par->getcurrtime() + PLUMTREE_IHAVE_TIMEOUT;
+			it = missingEvents.insert(make_pair(key, missing)).first;
+		}
+		it->second.announcers.push_back(msg->addr);
+	}
+}
+
+/**
+ * FUNCTION NAME: receiveGraft
+ *
+ * DESCRIPTION: Make the link to the sender eager and send it the BROADCAST it misses
+ */
+void MP1Node::receiveGraft(GraftView *msg) {
+	lazyPeers.erase(addressKey(&msg->addr));
+	unordered_map<unsigned long long, BroadcastView, AddressHash>::iterator it = seenEvents.find(eventKey(&msg->origin, msg->seq));
+	if (it != seenEvents.end()) {
+		sendBroadcast(&msg->addr, &it->second);
+	}
+}
+
+/**
+ * FUNCTION NAME: checkMissing
+ *
+ * DESCRIPTION: GRAFT the announced BROADCASTs whose eager copy is overdue, trying the
+ * 				next announcer every PLUMTREE_GRAFT_TIMEOUT ticks
+ */
+void MP1Node::checkMissing() {
+	map<unsigned long long, MissingEvent>::iterator it = missingEvents.begin();
+	while (it != missingEvents.end()) {
+		MissingEvent *missing = &it->second;
+		if (par->getcurrtime() < missing->deadline) {
+			++it;
+			continue;
+		}
+		if (missing->announcers.empty()) {
+			missingEvents.erase(it++);
+			continue;
+		}
+		Address to = missing->announcers.front();
+		missing->announcers.erase(missing->announcers.begin());
+		missing->deadline = par->getcurrtime() + PLUMTREE_GRAFT_TIMEOUT;
+		lazyPeers.erase(addressKey(&to));
+
+		char buf[GRAFT_WIRE_MAX];
+		WireWriter w(buf, sizeof(buf));
+		w.putHeader(GRAFT);
+		w.putAddress(&memberNode->addr);
+		w.putAddress(&missing->origin);
+		w.putVarint(missing->seq);
+		sendMessage(&to, buf, w.size(), SEND_UPDATE);
+		grafts++;
+		++it;
+	}
+}
+
+/**
+ * FUNCTION NAME: flushIHaves
+ *
+ * DESCRIPTION: Send the IHAVEs queued during this tick, batched per lazy peer
+ */
+void MP1Node::flushIHaves() {
+	if (lazyQueue.empty()) {
+		return;
+	}
+	stable_sort(lazyQueue.begin(), lazyQueue.end(), PendingIHave::byPeer);
+	size_t i = 0;
+	while (i < lazyQueue.size()) {
+		Address to = lazyQueue[i].to;
+		size_t n = 0;
+		while (i + n < lazyQueue.size() && n < IHAVE_MAX_EVENTS && lazyQueue[i + n].to == to) {
+			n++;
+		}
+		char buf[IHAVE_WIRE_MAX];
+		WireWriter w(buf, sizeof(buf));
+		w.putHeader(IHAVE);
+		w.putAddress(&memberNode->addr);
+		w.putVarint(n);
+		for (size_t k = i; k < i + n; ++k) {
+			w.putAddress(&lazyQueue[k].origin);
+			w.putVarint(lazyQueue[k].seq);
+		}
+		sendMessage(&to, buf, w.size(), SEND_UPDATE);
+		i += n;
+	}
+	lazyQueue.clear();
+}
+
+/**
+ * FUNCTION NAME: buildDigest
+ *
+ * DESCRIPTION: Digest of this node's membership list, including itself
+ */
+void MP1Node::buildDigest(MembershipDigest *digest) {
+	digest->clear();
+	digest->add(memberNode->addr.getId(), memberNode->addr.getPort(), ALIVE);
+	for (size_t i = 0; i < memberNode->memberList.size(); ++i) {
+		MemberListEntry *mle = &memberNode->memberList[i];
+		if (mle->id == memberNode->addr.getId() && mle->port == memberNode->addr.getPort()) {
+			continue;
+		}
+		digest->add(mle->id, mle->port, suspects.count(memberKey(mle->id, mle->port)) ? SUSPECT : ALIVE);
+	}
+}
+
+/**
+ * FUNCTION NAME: startSync
+ *
+ * DESCRIPTION: Start a push-pull anti-entropy round with a random member by sending it
+ * 				the bucket hashes of this node's digest
+ */
+void MP1Node::startSync() {
+	size_t n = memberNode->memberList.size();
+	if (n == 0) {
+		return;
+	}
+	MemberListEntry *mle = &memberNode->memberList[rand() % n];
+	Address to = Address(mle->id, mle->port);
+	if (to == memberNode->addr) {
+		return;
+	}
+	MembershipDigest digest;
+	buildDigest(&digest);
+
+	char buf[SYNCDIGEST_WIRE_MAX];
+	WireWriter w(buf, sizeof(buf));
+	w.putHeader(SYNCDIGEST);
+	w.putAddress(&memberNode->addr);
+	w.putByte(0);
+	w.putVarint(DIGEST_FANOUT);
+	for (size_t i = 0; i < DIGEST_FANOUT; ++i) {
+		w.putVarint(i);
+		w.putVarint(digest.bucket(i));
+	}
+	if (!sendMessage(&to, buf, w.size(), SEND_BULK)) {
+		return;
+	}
+	syncRounds++;
+	syncBytes += w.size();
+}
+
+/**
+ * FUNCTION NAME: answerSyncDigest
+ *
+ * DESCRIPTION: Compare a received SYNCDIGEST with this node's digest. Differing buckets
+ * 				are answered with their leaf hashes, differing leaves with their members.
+ */
+void MP1Node::answerSyncDigest(SyncDigestView *msg) {
+	MembershipDigest digest;
+	buildDigest(&digest);
+
+	unsigned short diff[DIGEST_LEAVES];
+	size_t n = 0;
+	for (size_t i = 0; i < msg->n; ++i) {
+		unsigned int mine = msg->level == 0 ? digest.bucket(msg->index[i]) : digest.leaf(msg->index[i]);
+		if (mine != msg->hash[i]) {
+			diff[n++] = msg->index[i];
+		}
+	}
+	if (n == 0) {
+		return;
+	}
+	if (msg->level == 1) {
+		sendSyncEntries(&msg->addr, diff, n, true);
+		return;
+	}
+
+	char buf[SYNCDIGEST_WIRE_MAX];
+	WireWriter w(buf, sizeof(buf));
+	w.putHeader(SYNCDIGEST);
+	w.putAddress(&memberNode->addr);
+	w.putByte(1);
+	w.putVarint(n * DIGEST_FANOUT);
+	for (size_t i = 0; i < n; ++i) {
+		for (size_t l = diff[i] * DIGEST_FANOUT; l < (diff[i] + 1u) * DIGEST_FANOUT; ++l) {
+			w.putVarint(l);
+			w.putVarint(digest.leaf(l));
+		}
+	}
+	if (sendMessage(&msg->addr, buf, w.size(), SEND_BULK)) {
+		syncBytes += w.size();
+	}
+}
+
+/**
+ * FUNCTION NAME: sendSyncEntries
+ *
+ * DESCRIPTION: Send the members of the given leaves, including this node and the
+ * 				removed ones, as many as fit into one message
+ */
+void MP1Node::sendSyncEntries(Address *to, unsigned short *leaves, size_t n, bool reply) {
+	bool wanted[DIGEST_LEAVES] = { false };
+	for (size_t i = 0; i < n; ++i) {
+		wanted[leaves[i]] = true;
+	}
+
+	vector<MemberStatusInfo> entries;
+	MemberStatusInfo entry;
+	if (wanted[MembershipDigest::leafOf(memberNode->addr.getId(), memberNode->addr.getPort())]) {
+		entry.status = ALIVE;
+		entry.info.id = memberNode->addr.getId(); entry.info.port = memberNode->addr.getPort(); entry.info.heartbeat = memberNode->heartbeat;
+		entry.info.incarnation = incarnation;
+		entries.push_back(entry);
+	}
+	for (size_t i = 0; i < memberNode->memberList.size(); ++i) {
+		MemberListEntry *mle = &memberNode->memberList[i];
+		if (!wanted[MembershipDigest::leafOf(mle->id, mle->port)] ||
+				(mle->id == memberNode->addr.getId() && mle->port == memberNode->addr.getPort())) {
+			continue;
+		}
+		memberEntry(mle, &entry);
+		entries.push_back(entry);
+	}
+	for (unordered_map<long long, Tombstone, AddressHash>::iterator it = removed.begin(); it != removed.end(); ++it) {
+		Address addr = keyAddress(it->first);
+		if (!wanted[MembershipDigest::leafOf(addr.getId(), addr.getPort())]) {
+			continue;
+		}
+		entry.status = DEAD;
+		entry.info.id = addr.getId(); entry.info.port = addr.getPort(); entry.info.heartbeat = it->second.heartbeat;
+		entry.info.incarnation = it->second.incarnation;
+		entries.push_back(entry);
+	}
+
+	vector<char> buf(emulNet->ENmaxsize());
+	WireWriter w(&buf[0], buf.size());
+	w.putHeader(SYNCENTRIES);
+	w.putAddress(&memberNode->addr);
+	w.putByte(reply ? 1 : 0);
+	w.putVarint(n);
+	for (size_t i = 0; i < n; ++i) {
+		w.putVarint(leaves[i]);
+	}
+	// the rest is repaired by later rounds
+	size_t fit = (buf.size() - min(buf.size(), w.size() + WIRE_VARINT32_MAX)) / (1 + MEMBERINFO_WIRE_MAX);
+	entries.resize(min(fit, entries.size()));
+	w.putVarint(entries.size());
+	long prev = 0;
+	for (size_t i = 0; i < entries.size(); ++i) {
+		w.putByte(entries[i].status);
+		putMemberInfo(&w, &entries[i].info, &prev);
+	}
+	if (!w.ok()) {
+		return;
+	}
+	if (sendMessage(to, &buf[0], w.size(), SEND_BULK)) {
+		syncEntries += entries.size();
+		syncBytes += w.size();
+	}
+}
@@ -14,113 +14,223 @@
 #include "Member.h"
 #include "EmulNet.h"
 #include "Queue.h"
-#include <byteswap.h>
+#include "ProbeScheduler.h"
+#include "LocalHealth.h"
+#include "GossipController.h"
+#include "SendBudget.h"
+#include "PartialView.h"
+#include "MembershipDigest.h"
+#include "Message.h"
+#include "AllocCounter.h"
+#include "NodeTask.h"
+#include "Scheduler.h"
 
 /**
  * Macros
  */
+// suspicion timeout bounds, ticks
 #define TREMOVE 20
 #define TFAIL 5
+// protocol periods a tombstone ignores ALIVE gossip from third parties about its member
+#define TOMBSTONE_TTL (2 * TREMOVE)
+// ticks to wait for the PONG of a probe
+#define PROBE_TIMEOUT 3
+// independent suspicions that bring the suspicion timeout down to TFAIL
+#define SUSPICION_K 3
+// 1: scale timeouts by local health and shrink suspicion with confirmations (Lifeguard)
+// 0: fixed PROBE_TIMEOUT, suspicion timeouts not scaled by local health
+#define LIFEGUARD 1
+// 1: fanout and interval of the PING rounds follow the group size and ack loss (see GossipController.h)
+// 0: one PING per tick
+#define ADAPTIVE_GOSSIP 1
+// 1: suspect members by phi-accrual over their heartbeat arrivals instead of probe timeouts
+#define PHI_ACCRUAL 0
+#define PHI_THRESHOLD 8.0
+// ticks without a new JOINREP fragment before asking for the missing ones
+#define JOINFRAG_TIMEOUT 2
+// ticks a JOINREP snapshot is kept for retransmissions
+#define JOIN_SNAPSHOT_TTL 20
+// ticks without a JOINREP before failing over to the next introducer
+#define JOIN_TIMEOUT 5
+// joiners served per tick before redirecting the rest
+#define JOIN_LOAD_MAX 8
+// ticks the joiners served in one tick are reported as the join load on PINGs and PONGs
+#define JOIN_LOAD_TTL 5
+// times a single JOINREQ may be redirected
+#define JOIN_MAX_REDIRECTS 1
+// ticks between push-pull anti-entropy rounds with a random member, 0: off
+#define ANTIENTROPY_PERIOD 5
+// BROADCASTs remembered to drop the copies arriving over other paths and to serve GRAFTs
+#define BROADCAST_SEEN_MAX 1024
+// 1: push BROADCASTs along Plumtree broadcast trees, 0: flood them over the active views
+#define PLUMTREE 1
+// ticks to wait for the eager copy of an announced BROADCAST, and for the answer to a GRAFT
+#define PLUMTREE_IHAVE_TIMEOUT 3
+#define PLUMTREE_GRAFT_TIMEOUT 2
+// initial size of the index of the updates of a tick, a power of 2
+#define UPDATE_SLOTS_MIN 64
+// ticks a departure is piggybacked with priority after it was learnt
+#define LEAVE_GOSSIP_TICKS 10
+// deferred messages kept for later ticks, the oldest is trimmed beyond
+#define SEND_DEFER_MAX 64
 
 /*
  * Note: You can change/add any functions in MP1Node.{h,cpp}
  */
 
 /**
- * Message Types
+ * STRUCT NAME: JoinSnapshot
+ *
+ * DESCRIPTION: Encoded JOINREP fragments kept to serve retransmissions
  */
-enum MsgTypes{
-    JOINREQ,
-    JOINREP,
-	PING,
-	PONG,
-    TEST,
-    DUMMYLASTMSGTYPE
-};
+typedef struct JoinSnapshot {
+	int created;
+	vector< vector<char> > fragments;
+} JoinSnapshot;
 
 /**
- * Member Status Types
+ * STRUCT NAME: Suspicion
+ *
+ * DESCRIPTION: A suspected member and who else suspects it
  */
-typedef enum MemberStatus {
-    ALIVE,
-    SUSPECT,
-	DEAD,
-} MemberStatus;
-
-char memberStatus(MemberStatus m);
+typedef struct Suspicion {
+	int start;
+	int confirmers[SUSPICION_K];
+	int n;
+} Suspicion;
 
 /**
- * STRUCT NAME: MessageHdr
+ * STRUCT NAME: PendingProbe
  *
- * DESCRIPTION: Header and content of a message
+ * DESCRIPTION: A PING waiting for its PONG
  */
-typedef struct MessageHdr {
-	enum MsgTypes msgType;
-} MessageHdr;
+typedef struct PendingProbe {
+	Address addr;
+	int sent;
+} PendingProbe;
 
 /**
- * STRUCT NAME: MemberInfo
+ * STRUCT NAME: Tombstone
  *
- * DESCRIPTION: Address and heartbeat
+ * DESCRIPTION: Last heartbeat and incarnation of a removed member, and when
+ * 				it was removed. Only gossip beyond either brings it back, and
+ * 				only a higher incarnation while the tombstone is fresh.
  */
-typedef struct IdPort {
-	IdPort(Address* addr) {
-		IdPort idPort = *(IdPort*)addr;
-		this->_id = idPort.getId();
-		this->_port = idPort.getPort();
-	}
-//	int getId() {return __bswap_32(_id); };
-	int getId() {return _id; };
-	void setId(int id) {_id = __bswap_32(id); };
-//	short getPort() { return __bswap_16(_port); };
-	short getPort() { return _port; };
-	void setPort(short port) { _port = __bswap_16(port); };
-private:
-	int _id;
-	short _port;
-} IdPort;
+typedef struct Tombstone {
+	long heartbeat;
+	unsigned int incarnation;
+	int time;
+} Tombstone;
 
-typedef struct MemberInfo {
-	int id;
-	short int port;
+/**
+ * STRUCT NAME: Departure
+ *
+ * DESCRIPTION: A member that left the group, gossiped as LEFT until the given tick
+ */
+typedef struct Departure {
+	Address addr;
 	long heartbeat;
-} MemberInfo;
-
-typedef struct TestPkg {
-	MessageHdr hdr;
-	Address adr;
-} TestPkg;
-
-typedef struct JoinReqPkg {
-	MessageHdr hdr;
-	Address adr;
-	long hrt;
-} JoinReqPkg;
-
-typedef struct JoinRepPkg {
-	MessageHdr hdr;
-	size_t n;
-	MemberInfo member;
-} JoinRepPkg;
-
-typedef struct MemberStatusInfo {
-	MemberStatus status;
-	MemberInfo info;
-} MemberStatusInfo;
-
-typedef struct PingPkg {
-	MessageHdr hdr;
-	Address adr;
-	size_t n;
-	MemberStatusInfo member;
-} PingPkg;
-
-typedef struct PongPkg {
-	MessageHdr hdr;
-	Address adr;
-	size_t n;
-	MemberStatusInfo member;
-} PongPkg;
+	unsigned int incarnation;
+	int until;
+} Departure;
+
+/**
+ * STRUCT NAME: DeferredSend
+ *
+ * DESCRIPTION: An update the send budget held back, sent when tokens allow
+ */
+typedef struct DeferredSend {
+	Address to;
+	vector<char> data;
+} DeferredSend;
+
+#ifdef COROUTINES
+/**
+ * STRUCT NAME: AckWait
+ *
+ * DESCRIPTION: A probe coroutine waiting for the PONG of a member, or for its timeout
+ */
+typedef struct AckWait {
+	Address addr;
+	int deadline;
+	std::coroutine_handle<> handle;
+	bool *acked;
+} AckWait;
+#endif
+
+/**
+ * STRUCT NAME: QueuedMsg
+ *
+ * DESCRIPTION: A received message waiting in the batch of this tick
+ */
+typedef struct QueuedMsg {
+	InboxMsg *elt;
+	unsigned char type;
+} QueuedMsg;
+
+/**
+ * STRUCT NAME: GossipUpdate
+ *
+ * DESCRIPTION: Merged member entries received during a tick, and who sent them.
+ * 				entry wins by compareStatus, alive is the ALIVE entry with the
+ * 				highest heartbeat, which applyGossip takes whatever the order.
+ */
+typedef struct GossipUpdate {
+	long long key;
+	// position in updateSlots
+	size_t slot;
+	MemberStatusInfo entry;
+	Address from[SUSPICION_K];
+	int n;
+	bool hasAlive;
+	MemberStatusInfo alive;
+	Address aliveFrom;
+} GossipUpdate;
+
+/**
+ * STRUCT NAME: TickAllocs
+ *
+ * DESCRIPTION: Allocation count and membership state at the start of a tick.
+ * 				A tick that only handled PINGs and PONGs and left them unchanged
+ * 				is steady state, and must not allocate, neither in nodeLoop nor
+ * 				while recvLoop queued its messages.
+ */
+typedef struct TickAllocs {
+	unsigned long allocs;
+	size_t members;
+	long suspicions;
+	long refutedSuspicions;
+	long removals;
+	long syncRounds;
+	long sendsDeferred;
+	size_t capacity;
+} TickAllocs;
+
+/**
+ * STRUCT NAME: MissingEvent
+ *
+ * DESCRIPTION: A BROADCAST announced by IHAVE that did not arrive yet
+ */
+typedef struct MissingEvent {
+	Address origin;
+	unsigned int seq;
+	int deadline;
+	vector<Address> announcers;
+} MissingEvent;
+
+/**
+ * STRUCT NAME: PendingIHave
+ *
+ * DESCRIPTION: A BROADCAST to announce to a lazy peer at the end of the tick
+ */
+typedef struct PendingIHave {
+	Address to;
+	Address origin;
+	unsigned int seq;
+	static bool byPeer(const PendingIHave &a, const PendingIHave &b) {
+		return a.to.key < b.to.key;
+	}
+} PendingIHave;
 
 /**
  * CLASS NAME: MP1Node
@@ -133,7 +243,99 @@ private:
 	Log *log;
 	Params *par;
 	Member *memberNode;
-	char NULLADDR[6];
+	ProbeScheduler probes;
+	// received messages that failed validation
+	long droppedMsgs;
+	// position of every address in the membership list
+	unordered_map<long long, size_t, AddressHash> memberIndex;
+	// suspected members, and the tombstones of removed ones
+	unordered_map<long long, Suspicion, AddressHash> suspects;
+	unordered_map<long long, Tombstone, AddressHash> removed;
+	// this node's incarnation, raised to refute suspicions about it
+	unsigned int incarnation;
+	// probes waiting for their PONG
+	vector<PendingProbe> pendingProbes;
+	// recent graceful leaves, and whether this node left
+	vector<Departure> departures;
+	bool left;
+	long leavesReceived;
+	// outgoing bytes, and the updates waiting for them in FIFO order
+	SendBudget budget;
+	vector<DeferredSend> deferredSends;
+	long sendsDeferred;
+	long sendsTrimmed;
+#ifdef COROUTINES
+	// coroutine driver: the receiver waiting for messages, probes waiting for their PONG
+	Scheduler *sched;
+	std::coroutine_handle<> msgWaiter;
+	vector<AckWait> ackWaits;
+#endif
+	LocalHealth health;
+	GossipController gossipCtl;
+	// failure detection counters
+	long suspicions;
+	long refutedSuspicions;
+	long removals;
+	// messages, member entries and PINGs to answer of this tick
+	vector<QueuedMsg> batch;
+	vector<GossipUpdate> updates;
+	// open addressing index of updates by member key, holding update index + 1
+	vector<unsigned int> updateSlots;
+	vector<Address> pongs;
+	// true while the batch of this tick only holds PINGs and PONGs
+	bool pingBatch;
+	// heap allocations and inbox pool growth of the last recvLoop, checked by nodeLoop
+	int recvTick;
+	unsigned long recvAllocs;
+	long recvPooled;
+	long gossipReceived;
+	long gossipApplied;
+	// JOINREQs received during this tick
+	vector<JoinReqView> pendingJoins;
+	// JOINREP snapshots served by this node, by snapshot id
+	map<unsigned int, JoinSnapshot> snapshots;
+	unsigned int nextSnapshot;
+	// JOINREP fragments received by this node
+	Address joinFrom;
+	unsigned int joinSnapshot;
+	vector<bool> joinFragments;
+	size_t joinMissing;
+	int joinProgress;
+	// where and when this node last sent its JOINREQ
+	Address joinAddr;
+	int joinSent;
+	int joinAttempts;
+	unsigned char joinRedirects;
+	// join handling counters
+	long joinsHandled;
+	long joinsRedirected;
+	long joinFailovers;
+	// joiners served in the last tick that had any, and that tick
+	int joinLoad;
+	int joinLoadTick;
+	// partial view mode: the membership list is the active view
+	PartialView view;
+	// NEIGHBOR request waiting for its reply, neighborSent -1 if none
+	Address neighborAddr;
+	int neighborSent;
+	// BROADCASTs sent by this node, and the latest ones seen
+	unsigned int broadcastSeq;
+	unordered_map<unsigned long long, BroadcastView, AddressHash> seenEvents;
+	queue<unsigned long long> seenOrder;
+	// broadcast tree: active neighbours only announced to, BROADCASTs announced but missing
+	unordered_set<long long, AddressHash> lazyPeers;
+	map<unsigned long long, MissingEvent> missingEvents;
+	vector<PendingIHave> lazyQueue;
+	// partial view counters
+	long shuffles;
+	long broadcasts;
+	long broadcastDuplicates;
+	long grafts;
+	long prunes;
+	// anti-entropy counters
+	long syncRounds;
+	long syncEntries;
+	long syncBytes;
 
 public:
 	MP1Node(Member *, Params *, EmulNet *, Log *, Address *);
@@ -146,16 +348,131 @@ public:
 	int initThisNode(Address *joinaddr);
 	int introduceSelfToGroup(Address *joinAddress);
 	int finishUpThisNode();
+	void leaveGroup();
 	void nodeLoop();
 	void checkMessages();
 	bool recvCallBack(void *env, char *data, int size);
+	void queueUpdate(const MemberStatusInfo *entry, Address *from);
+	void applyUpdates();
+	GossipUpdate *findUpdate(long long key, size_t *slot);
+	void growUpdateSlots();
+	void startTickAllocs(TickAllocs *tick);
+	void checkTickAllocs(TickAllocs *tick);
+	void sendPing(Address *to, enum MsgTypes type);
+	bool sendMessage(Address *to, char *data, size_t size, enum SendClass cls);
+	void flushDeferred();
+	void sendJoinReq(Address *to);
+	void answerJoins();
+	bool redirectJoin(Address *joiner);
+	unsigned char reportedJoinLoad();
+	unsigned int buildJoinSnapshot();
+	void sendJoinFragments(unsigned int id, Address *to);
+	void resendJoinFragments(JoinFragReqView *req);
+	void checkJoin();
+	void expireJoinSnapshots();
 	void nodeLoopOps();
 	int isNullAddress(Address *addr);
 	Address getJoinAddress();
 	void initMemberListTable(Member *memberNode);
 	void printAddress(Address *addr);
 	bool inMemberList(Address *addr);
+	MemberListEntry *findMember(Address *addr);
+	void addMember(Address *addr, long heartbeat);
+	void removeMember(Address *addr);
+	void departMember(Address *addr, unsigned int incarnation, long heartbeat);
+	bool unlinkMember(Address *addr, Tombstone *tomb);
+	void memberEntry(MemberListEntry *mle, MemberStatusInfo *entry);
+	void applyGossip(const MemberStatusInfo *entry, Address *from);
+	void suspect(Address *addr, Address *from);
+	bool pickGossip(Address *to, MemberStatusInfo *entry);
+	void checkProbes();
+	void probeMissed(Address *addr);
+#ifdef COROUTINES
+	void setScheduler(Scheduler *sched);
+	NodeTask receiveTask();
+	NodeTask tickTask();
+	NodeTask probeTask(Address addr);
+	void waitMessages(std::coroutine_handle<> handle);
+	void notifyMessages();
+	void waitAck(Address *addr, int ticks, std::coroutine_handle<> handle, bool *acked);
+	void forgetAck(std::coroutine_handle<> handle);
+	bool ackProbe(Address *addr);
+	bool awaitingAck(Address *addr);
+#endif
+	void checkSuspects();
+	void checkPhi();
+	int protocolPeriod();
+	int suspicionTimeout(Suspicion *s);
+	void sendOverlay(Address *to, enum MsgTypes type, Address *subject, unsigned int arg, Address *addrs, size_t n);
+	void joinOverlay(Address *joiner);
+	void forwardJoin(OverlayView *msg);
+	void addNeighbor(Address *addr);
+	void dropNeighbor(Address *addr);
+	bool randomNeighbor(Address *addr, Address *except1, Address *except2);
+	void mergePassive(Address *addr);
+	void fillActiveView();
+	void shuffleViews();
+	void forwardShuffle(OverlayView *msg);
+	void broadcast(MemberStatus event, Address *subject);
+	void deliverBroadcast(BroadcastView *msg);
+	void sendBroadcast(Address *to, BroadcastView *msg);
+	bool markSeen(BroadcastView *msg);
+	void receiveIHave(IHaveView *msg);
+	void receiveGraft(GraftView *msg);
+	void checkMissing();
+	void flushIHaves();
+	void buildDigest(MembershipDigest *digest);
+	void startSync();
+	void answerSyncDigest(SyncDigestView *msg);
+	void sendSyncEntries(Address *to, unsigned short *leaves, size_t n, bool reply);
 	virtual ~MP1Node();
 };
 
+#ifdef COROUTINES
+/**
+ * STRUCT NAME: MessageAwait
+ *
+ * DESCRIPTION: co_await MessageAwait(node) resumes once the node's inbox holds messages
+ */
+struct MessageAwait {
+	MP1Node *node;
+	MessageAwait(MP1Node *node): node(node) {}
+	bool await_ready() {
+		return node->getMemberNode()->mp1q.size() > 0;
+	}
+	void await_suspend(std::coroutine_handle<> handle) {
+		node->waitMessages(handle);
+	}
+	void await_resume() {}
+};
+
+/**
+ * STRUCT NAME: AckAwait
+ *
+ * DESCRIPTION: co_await AckAwait(node, addr, ticks) resumes with true when a PONG
+ * 				from addr arrives, or with false after ticks ticks
+ */
+struct AckAwait {
+	MP1Node *node;
+	Address addr;
+	int ticks;
+	bool acked;
+	std::coroutine_handle<> handle;
+	AckAwait(MP1Node *node, Address addr, int ticks): node(node), addr(addr), ticks(ticks), acked(false) {}
+	bool await_ready() {
+		return false;
+	}
+	void await_suspend(std::coroutine_handle<> handle) {
+		this->handle = handle;
+		node->waitAck(&addr, ticks, handle, &acked);
+	}
+	bool await_resume() {
+		if (!acked) {
+			node->forgetAck(handle);
+		}
+		return acked;
+	}
+};
+#endif
+
 #endif /* _MP1NODE_H_ */
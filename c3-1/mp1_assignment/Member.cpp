@@ -11,39 +11,15 @@
  */
 q_elt::q_elt(void *elt, int size): elt(elt), size(size) {}
 
-/**
- * Copy constructor
- */
-Address::Address(const Address &anotherAddress) {
-	// strcpy(addr, anotherAddress.addr);
-	memcpy(&addr, &anotherAddress.addr, sizeof(addr));
-}
-
-/**
- * Assignment operator overloading
- */
-Address& Address::operator =(const Address& anotherAddress) {
-	// strcpy(addr, anotherAddress.addr);
-	memcpy(&addr, &anotherAddress.addr, sizeof(addr));
-	return *this;
-}
-
-/**
- * Compare two Address objects
- */
-bool Address::operator ==(const Address& anotherAddress) {
-	return memcmp(this->addr, anotherAddress.addr, sizeof(this->addr)) == 0;
-}
-
 /**
  * Constructor
  */
-MemberListEntry::MemberListEntry(int id, short port, long heartbeat, long timestamp): id(id), port(port), heartbeat(heartbeat), timestamp(timestamp) {}
+MemberListEntry::MemberListEntry(int id, short port, long heartbeat, long timestamp): id(id), port(port), heartbeat(heartbeat), timestamp(timestamp), incarnation(0), joinLoad(0) {}
 
 /**
  * Constuctor
  */
-MemberListEntry::MemberListEntry(int id, short port): id(id), port(port) {}
+MemberListEntry::MemberListEntry(int id, short port): id(id), port(port), incarnation(0), joinLoad(0) {}
 
 /**
  * Copy constructor
@@ -53,6 +29,9 @@ MemberListEntry::MemberListEntry(const MemberListEntry &anotherMLE) {
 	this->id = anotherMLE.id;
 	this->port = anotherMLE.port;
 	this->timestamp = anotherMLE.timestamp;
+	this->incarnation = anotherMLE.incarnation;
+	this->joinLoad = anotherMLE.joinLoad;
+	this->arrivals = anotherMLE.arrivals;
 }
 
 /**
@@ -64,6 +43,9 @@ MemberListEntry& MemberListEntry::operator =(const MemberListEntry &anotherMLE)
 	swap(id, temp.id);
 	swap(port, temp.port);
 	swap(timestamp, temp.timestamp);
+	swap(incarnation, temp.incarnation);
+	swap(joinLoad, temp.joinLoad);
+	swap(arrivals, temp.arrivals);
 	return *this;
 }
 
@@ -153,7 +135,7 @@ Member::Member(const Member &anotherMember) {
 	this->timeOutCounter = anotherMember.timeOutCounter;
 	this->memberList = anotherMember.memberList;
 	this->myPos = anotherMember.myPos;
-	this->mp1q = anotherMember.mp1q;
+	// the inbox is not copied, queued messages stay with their receiver
 }
 
 /**
@@ -170,6 +152,5 @@ Member& Member::operator =(const Member& anotherMember) {
 	this->timeOutCounter = anotherMember.timeOutCounter;
 	this->memberList = anotherMember.memberList;
 	this->myPos = anotherMember.myPos;
-	this->mp1q = anotherMember.mp1q;
 	return *this;
 }
@@ -8,6 +8,8 @@
 #define MEMBER_H_
 
 #include "stdincludes.h"
+#include "PhiAccrual.h"
+#include "Inbox.h"
 
 /**
  * CLASS NAME: q_elt
@@ -24,33 +26,68 @@ public:
 /**
  * CLASS NAME: Address
  *
- * DESCRIPTION: Class representing the address of a single node
+ * DESCRIPTION: Class representing the address of a single node.
+ * 				The id and port are packed into one 64-bit key, so copies,
+ * 				comparisons and hashing are single integer operations.
  */
 class Address {
 public:
-	char addr[6];
-	Address() {}
-	// Copy constructor
-	Address(const Address &anotherAddress);
-	 // Overloaded = operator
-	Address& operator =(const Address &anotherAddress);
-	bool operator ==(const Address &anotherAddress);
+	// id in the low 32 bits, port in the 16 above, the rest 0
+	unsigned long long key;
+	constexpr Address(): key(0) {}
+	constexpr Address(int id, short port):
+		key((unsigned long long)(unsigned int)id | (unsigned long long)(unsigned short)port << 32) {}
+	constexpr explicit Address(unsigned long long key): key(key) {}
 	Address(string address) {
 		size_t pos = address.find(":");
 		int id = stoi(address.substr(0, pos));
 		short port = (short)stoi(address.substr(pos + 1, address.size()-pos-1));
-		memcpy(&addr[0], &id, sizeof(int));
-		memcpy(&addr[4], &port, sizeof(short));
+		*this = Address(id, port);
 	}
-	string getAddress() {
-		int id = 0;
-		short port;
-		memcpy(&id, &addr[0], sizeof(int));
-		memcpy(&port, &addr[4], sizeof(short));
-		return to_string(id) + ":" + to_string(port);
+	constexpr int getId() const {
+		return (int)(unsigned int)key;
+	}
+	constexpr short getPort() const {
+		return (short)(unsigned short)(key >> 32);
+	}
+	// i-th byte of the id, signed like the char array logs always printed
+	constexpr int getByte(int i) const {
+		return (signed char)(key >> (8 * i));
+	}
+	constexpr bool operator ==(const Address &anotherAddress) const {
+		return key == anotherAddress.key;
+	}
+	constexpr bool operator !=(const Address &anotherAddress) const {
+		return key != anotherAddress.key;
+	}
+	constexpr bool isNull() const {
+		return key == 0;
+	}
+	string getAddress() const {
+		return to_string(getId()) + ":" + to_string(getPort());
 	}
 	void init() {
-		memset(&addr, 0, sizeof(addr));
+		key = 0;
+	}
+};
+
+static_assert(sizeof(Address) == 8 && is_trivially_copyable<Address>::value, "Address must stay a plain 64-bit key");
+
+/**
+ * STRUCT NAME: AddressHash
+ *
+ * DESCRIPTION: Hash of an Address, or of its key, for unordered containers.
+ * 				The splitmix64 finalizer spreads the few id bits that differ
+ * 				over the whole word.
+ */
+struct AddressHash {
+	size_t operator ()(unsigned long long key) const {
+		key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+		return (size_t)(key ^ (key >> 31));
+	}
+	size_t operator ()(const Address &addr) const {
+		return (*this)(addr.key);
 	}
 };
 
@@ -65,9 +102,15 @@ public:
 	short port;
 	long heartbeat;
 	long timestamp;
+	// highest incarnation heard of, raised by the member to refute suspicions
+	unsigned int incarnation;
+	// joiners the member last reported serving in a tick, see MP1Node::redirectJoin
+	unsigned char joinLoad;
+	// heartbeat arrival history
+	PhiAccrual arrivals;
 	MemberListEntry(int id, short port, long heartbeat, long timestamp);
 	MemberListEntry(int id, short port);
-	MemberListEntry(): id(0), port(0), heartbeat(0), timestamp(0) {}
+	MemberListEntry(): id(0), port(0), heartbeat(0), timestamp(0), incarnation(0), joinLoad(0) {}
 	MemberListEntry(const MemberListEntry &anotherMLE);
 	MemberListEntry& operator =(const MemberListEntry &anotherMLE);
 	int getid();
@@ -109,7 +152,7 @@ public:
 	// My position in the membership table
 	vector<MemberListEntry>::iterator myPos;
 	// Queue for failure detection messages
-	queue<q_elt> mp1q;
+	Inbox mp1q;
 	/**
 	 * Constructor
 	 */
@@ -0,0 +1,71 @@
+/**********************************
+ * FILE NAME: MembershipDigest.cpp
+ *
+ * DESCRIPTION: Definition of MembershipDigest class
+ **********************************/
+
+#include "MembershipDigest.h"
+
+/**
+ * FUNCTION NAME: mix
+ *
+ * DESCRIPTION: 64-bit finalizer of MurmurHash3
+ */
+static unsigned long long mix(unsigned long long h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+/**
+ * FUNCTION NAME: leafOf
+ *
+ * DESCRIPTION: Leaf of a member
+ */
+unsigned int MembershipDigest::leafOf(int id, short port) {
+	return (unsigned int)(mix(((unsigned long long)(unsigned int)id << 16) | (unsigned short)port) % DIGEST_LEAVES);
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Digest of an empty membership
+ */
+void MembershipDigest::clear() {
+	memset(leaves, 0, sizeof(leaves));
+	memset(buckets, 0, sizeof(buckets));
+}
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Add a member. Sums do not depend on the order members are added in.
+ */
+void MembershipDigest::add(int id, short port, int status) {
+	unsigned long long key = ((unsigned long long)(unsigned int)id << 16) | (unsigned short)port;
+	unsigned int h = (unsigned int)mix(key ^ ((unsigned long long)(status + 1) << 56));
+	unsigned int l = leafOf(id, port);
+	leaves[l] += h;
+	buckets[l / DIGEST_FANOUT] += h;
+}
+
+/**
+ * FUNCTION NAME: bucket
+ *
+ * DESCRIPTION: Hash of the i-th bucket, the sum of its leaves
+ */
+unsigned int MembershipDigest::bucket(size_t i) {
+	return buckets[i];
+}
+
+/**
+ * FUNCTION NAME: leaf
+ *
+ * DESCRIPTION: Hash of the i-th leaf
+ */
+unsigned int MembershipDigest::leaf(size_t i) {
+	return leaves[i];
+}
@@ -0,0 +1,43 @@
+/**********************************
+ * FILE NAME: MembershipDigest.h
+ *
+ * DESCRIPTION: Header file of MembershipDigest class
+ **********************************/
+
+#ifndef MEMBERSHIPDIGEST_H_
+#define MEMBERSHIPDIGEST_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// children per digest node; the tree has DIGEST_FANOUT buckets of DIGEST_FANOUT leaves
+#define DIGEST_FANOUT 16
+#define DIGEST_LEAVES (DIGEST_FANOUT * DIGEST_FANOUT)
+
+/**
+ * CLASS NAME: MembershipDigest
+ *
+ * DESCRIPTION: Two level Merkle tree over the membership. Members are spread over
+ * 				the leaves by a hash of their id; a leaf hashes the (id, port, status)
+ * 				of its members and a bucket sums its leaves. Two nodes compare the
+ * 				buckets first and the leaves of differing buckets next, so only the
+ * 				members of differing leaves have to be exchanged.
+ * 				Heartbeats are left out, they advance on every tick.
+ */
+class MembershipDigest {
+private:
+	unsigned int leaves[DIGEST_LEAVES];
+	unsigned int buckets[DIGEST_FANOUT];
+public:
+	MembershipDigest() { clear(); }
+	virtual ~MembershipDigest() {}
+	static unsigned int leafOf(int id, short port);
+	void clear();
+	void add(int id, short port, int status);
+	unsigned int bucket(size_t i);
+	unsigned int leaf(size_t i);
+};
+
+#endif /* MEMBERSHIPDIGEST_H_ */
@@ -0,0 +1,494 @@
+/**********************************
+ * FILE NAME: Message.cpp
+ *
+ * DESCRIPTION: Membership protocol messages.
+ * 				Entry encoding and validation of received messages.
+ **********************************/
+
+#include "Message.h"
+
+/**
+ * FUNCTION NAME: memberStatus
+ *
+ * DESCRIPTION: One letter tag of a member status
+ */
+char memberStatus(MemberStatus m) {
+	switch (m) {
+		case ALIVE: return 'A';
+		case SUSPECT: return 'S';
+		case DEAD: return 'D';
+		case LEFT: return 'L';
+	}
+	return '?';
+}
+
+/**
+ * FUNCTION NAME: compareStatus
+ *
+ * DESCRIPTION: Order two entries about the same member: the higher incarnation
+ * 				wins. Within an incarnation LEFT beats everything, ALIVE beats
+ * 				SUSPECT and DEAD only with a newer heartbeat, which only the
+ * 				member itself can have produced, and DEAD beats SUSPECT.
+ *
+ * RETURNS:
+ * < 0, 0 or > 0 as a is older, equal to or newer than b
+ */
+int compareStatus(const MemberStatusInfo *a, const MemberStatusInfo *b) {
+	if (a->info.incarnation != b->info.incarnation) {
+		return a->info.incarnation < b->info.incarnation ? -1 : 1;
+	}
+	if (a->status == b->status) {
+		return 0;
+	}
+	if (a->status == LEFT || b->status == LEFT) {
+		return a->status == LEFT ? 1 : -1;
+	}
+	if (a->status == ALIVE) {
+		return a->info.heartbeat > b->info.heartbeat ? 1 : -1;
+	}
+	if (b->status == ALIVE) {
+		return b->info.heartbeat > a->info.heartbeat ? -1 : 1;
+	}
+	return (int)a->status - (int)b->status;
+}
+
+/**
+ * FUNCTION NAME: putMemberInfo
+ *
+ * DESCRIPTION: Encode a member entry, heartbeat relative to the previous entry
+ */
+void putMemberInfo(WireWriter *w, MemberInfo *info, long *prev) {
+	w->putVarint((unsigned int)info->id);
+	w->putVarint((unsigned short)info->port);
+	w->putVarint(info->incarnation);
+	w->putZigzag(info->heartbeat - *prev);
+	*prev = info->heartbeat;
+}
+
+/**
+ * FUNCTION NAME: memberInfoSize
+ *
+ * DESCRIPTION: Encoded size of a member entry, see putMemberInfo
+ */
+static size_t memberInfoSize(MemberInfo *info, long prev) {
+	char buf[MEMBERINFO_WIRE_MAX];
+	WireWriter w(buf, sizeof(buf));
+	putMemberInfo(&w, info, &prev);
+	return w.size();
+}
+
+/**
+ * FUNCTION NAME: encodeJoinSnapshot
+ *
+ * DESCRIPTION: Encode the membership list as JOINREP fragments of at most maxSize bytes each
+ */
+void encodeJoinSnapshot(Address *from, vector<MemberListEntry> &list, unsigned int snapshot,
+		size_t maxSize, vector< vector<char> > *fragments) {
+	size_t budget = maxSize - JOINREP_HDR_MAX;
+	// first entry of every fragment, heartbeat deltas restart at each one
+	vector<size_t> starts;
+	starts.push_back(0);
+	size_t used = 0;
+	long prev = 0;
+	for (size_t i = 0; i < list.size(); ++i) {
+		MemberInfo info;
+		info.id = list[i].id; info.port = list[i].port; info.heartbeat = list[i].heartbeat; info.incarnation = list[i].incarnation;
+		size_t sz = memberInfoSize(&info, prev);
+		if (used + sz > budget && used > 0) {
+			starts.push_back(i);
+			used = 0;
+			prev = 0;
+			sz = memberInfoSize(&info, prev);
+		}
+		used += sz;
+		prev = info.heartbeat;
+	}
+	starts.push_back(list.size());
+
+	size_t count = starts.size() - 1;
+	fragments->clear();
+	fragments->resize(count);
+	for (size_t f = 0; f < count; ++f) {
+		vector<char> &buf = (*fragments)[f];
+		buf.resize(maxSize);
+		WireWriter w(&buf[0], maxSize);
+		w.putHeader(JOINREP);
+		w.putAddress(from);
+		w.putVarint(snapshot);
+		w.putVarint(f);
+		w.putVarint(count);
+		w.putVarint(starts[f + 1] - starts[f]);
+		prev = 0;
+		for (size_t i = starts[f]; i < starts[f + 1]; ++i) {
+			MemberInfo info;
+			info.id = list[i].id; info.port = list[i].port; info.heartbeat = list[i].heartbeat; info.incarnation = list[i].incarnation;
+			putMemberInfo(&w, &info, &prev);
+		}
+		buf.resize(w.size());
+	}
+}
+
+/**
+ * FUNCTION NAME: getMessageType
+ *
+ * DESCRIPTION: Read the type of a received message
+ *
+ * RETURNS:
+ * false if the message is too short or of an unknown format version
+ */
+bool getMessageType(const char *data, int size, unsigned char *type) {
+	if (size < 0) {
+		return false;
+	}
+	WireReader r(data, size);
+	return r.getHeader(type);
+}
+
+/**
+ * FUNCTION NAME: readVarint
+ *
+ * DESCRIPTION: Decode a varint of an already validated buffer
+ */
+static const unsigned char *readVarint(const unsigned char *p, unsigned long long *v) {
+	unsigned long long result = 0;
+	int shift = 0;
+	while (*p & 0x80) {
+		result |= (unsigned long long)(*p++ & 0x7f) << shift;
+		shift += 7;
+	}
+	result |= (unsigned long long)(*p++) << shift;
+	*v = result;
+	return p;
+}
+
+/**
+ * Constructor
+ */
+MemberListView::iterator::iterator(const unsigned char *pos, const unsigned char *last, bool withStatus):
+		pos(pos), next(pos), last(last), withStatus(withStatus), prev(0) {
+	decode();
+}
+
+/**
+ * FUNCTION NAME: decode
+ *
+ * DESCRIPTION: Decode the entry at pos without bounds checks, parse() already did them
+ */
+void MemberListView::iterator::decode() {
+	if (pos == last) {
+		return;
+	}
+	const unsigned char *p = pos;
+	unsigned long long v;
+	cur.status = ALIVE;
+	if (withStatus) {
+		cur.status = (MemberStatus)*p++;
+	}
+	p = readVarint(p, &v);
+	cur.info.id = (int)v;
+	p = readVarint(p, &v);
+	cur.info.port = (short)v;
+	p = readVarint(p, &v);
+	cur.info.incarnation = (unsigned int)v;
+	p = readVarint(p, &v);
+	prev += (long)((long long)(v >> 1) ^ -(long long)(v & 1));
+	cur.info.heartbeat = prev;
+	next = p;
+}
+
+/**
+ * FUNCTION NAME: operator ++
+ *
+ * DESCRIPTION: Step to the next entry
+ */
+MemberListView::iterator &MemberListView::iterator::operator ++() {
+	pos = next;
+	decode();
+	return *this;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate an entry count and that many entries
+ *
+ * RETURNS:
+ * false if any entry is truncated or out of range
+ */
+bool MemberListView::parse(WireReader *r, bool withStatus) {
+	unsigned long long count;
+	if (!r->getVarint(&count) || count > r->remaining()) {
+		return false;
+	}
+	this->withStatus = withStatus;
+	first = (const unsigned char *)r->cursor();
+	for (unsigned long long i = 0; i < count; ++i) {
+		unsigned char status;
+		unsigned long long id, port, incarnation;
+		long long delta;
+		if (withStatus && (!r->getByte(&status) || status > LEFT)) {
+			return false;
+		}
+		if (!r->getVarint(&id) || id > 0xffffffffULL || !r->getVarint(&port) || port > 0xffffULL ||
+				!r->getVarint(&incarnation) || incarnation > 0xffffffffULL || !r->getZigzag(&delta)) {
+			return false;
+		}
+	}
+	last = (const unsigned char *)r->cursor();
+	n = count;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a JOINREQ
+ */
+bool JoinReqView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	long long hrt;
+	if (!r.getHeader(&type) || !r.getAddress(&addr) || !r.getZigzag(&hrt) || !r.getByte(&redirects)) {
+		return false;
+	}
+	heartbeat = hrt;
+	return r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a JOINREP
+ */
+bool JoinRepView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	unsigned long long snap, frag, frags;
+	if (!r.getHeader(&type) || !r.getAddress(&addr) || !r.getVarint(&snap) || snap > 0xffffffffULL ||
+			!r.getVarint(&frag) || !r.getVarint(&frags) || frags > JOINREP_MAX_FRAGMENTS || frag >= frags) {
+		return false;
+	}
+	snapshot = snap;
+	fragment = frag;
+	fragments = frags;
+	return members.parse(&r, false) && r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a JOINFRAGREQ
+ */
+bool JoinFragReqView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	unsigned long long snap, count;
+	if (!r.getHeader(&type) || !r.getAddress(&addr) || !r.getVarint(&snap) || snap > 0xffffffffULL ||
+			!r.getVarint(&count) || count > JOINFRAG_MAX_RANGES) {
+		return false;
+	}
+	snapshot = snap;
+	n = count;
+	for (size_t i = 0; i < n; ++i) {
+		unsigned long long first, len;
+		if (!r.getVarint(&first) || first > 0xffffffffULL || !r.getVarint(&len) || len > 0xffffffffULL - first) {
+			return false;
+		}
+		ranges[i].first = first;
+		ranges[i].count = len;
+	}
+	return r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a PING or PONG
+ */
+bool PingView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	return r.getHeader(&type) && r.getAddress(&addr) && r.getByte(&joinLoad) && members.parse(&r, true) && r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a JOINREDIRECT
+ */
+bool JoinRedirectView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	return r.getHeader(&type) && r.getAddress(&addr) && r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate an overlay message
+ */
+bool OverlayView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	unsigned long long a, count;
+	if (!r.getHeader(&type) || !r.getAddress(&addr) || !r.getAddress(&subject) ||
+			!r.getVarint(&a) || a > 0xffffffffULL || !r.getVarint(&count) || count > OVERLAY_MAX_ADDRS) {
+		return false;
+	}
+	arg = a;
+	n = count;
+	for (size_t i = 0; i < n; ++i) {
+		if (!r.getAddress(&addrs[i])) {
+			return false;
+		}
+	}
+	return r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a BROADCAST
+ */
+bool BroadcastView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type, ev;
+	unsigned long long s;
+	if (!r.getHeader(&type) || !r.getAddress(&addr) || !r.getAddress(&origin) ||
+			!r.getVarint(&s) || s > 0xffffffffULL || !r.getByte(&ev) || ev > DEAD || !r.getAddress(&subject)) {
+		return false;
+	}
+	seq = s;
+	event = (MemberStatus)ev;
+	return r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a SYNCDIGEST
+ */
+bool SyncDigestView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	unsigned long long count;
+	if (!r.getHeader(&type) || !r.getAddress(&addr) || !r.getByte(&level) || level > 1 ||
+			!r.getVarint(&count) || count > DIGEST_LEAVES) {
+		return false;
+	}
+	n = count;
+	size_t limit = level == 0 ? DIGEST_FANOUT : DIGEST_LEAVES;
+	for (size_t i = 0; i < n; ++i) {
+		unsigned long long idx, h;
+		if (!r.getVarint(&idx) || idx >= limit || !r.getVarint(&h) || h > 0xffffffffULL) {
+			return false;
+		}
+		index[i] = idx;
+		hash[i] = h;
+	}
+	return r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a SYNCENTRIES
+ */
+bool SyncEntriesView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type, rep;
+	unsigned long long count;
+	if (!r.getHeader(&type) || !r.getAddress(&addr) || !r.getByte(&rep) || rep > 1 ||
+			!r.getVarint(&count) || count > DIGEST_LEAVES) {
+		return false;
+	}
+	reply = rep == 1;
+	n = count;
+	for (size_t i = 0; i < n; ++i) {
+		unsigned long long leaf;
+		if (!r.getVarint(&leaf) || leaf >= DIGEST_LEAVES) {
+			return false;
+		}
+		leaves[i] = leaf;
+	}
+	return members.parse(&r, true) && r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate an IHAVE
+ */
+bool IHaveView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	unsigned long long count;
+	if (!r.getHeader(&type) || !r.getAddress(&addr) || !r.getVarint(&count) || count > IHAVE_MAX_EVENTS) {
+		return false;
+	}
+	n = count;
+	for (size_t i = 0; i < n; ++i) {
+		unsigned long long s;
+		if (!r.getAddress(&origins[i]) || !r.getVarint(&s) || s > 0xffffffffULL) {
+			return false;
+		}
+		seqs[i] = s;
+	}
+	return r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a GRAFT
+ */
+bool GraftView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	unsigned long long s;
+	if (!r.getHeader(&type) || !r.getAddress(&addr) || !r.getAddress(&origin) || !r.getVarint(&s) || s > 0xffffffffULL) {
+		return false;
+	}
+	seq = s;
+	return r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a PRUNE
+ */
+bool PruneView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	return r.getHeader(&type) && r.getAddress(&addr) && r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a LEAVE
+ */
+bool LeaveView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	unsigned long long inc;
+	long long hrt;
+	if (!r.getHeader(&type) || !r.getAddress(&addr) || !r.getVarint(&inc) || inc > 0xffffffffULL || !r.getZigzag(&hrt)) {
+		return false;
+	}
+	incarnation = (unsigned int)inc;
+	heartbeat = hrt;
+	return r.remaining() == 0;
+}
+
+/**
+ * FUNCTION NAME: parse
+ *
+ * DESCRIPTION: Validate a TEST
+ */
+bool TestView::parse(const char *data, int size) {
+	WireReader r(data, size);
+	unsigned char type;
+	return r.getHeader(&type) && r.getAddress(&addr) && r.remaining() == 0;
+}
@@ -0,0 +1,405 @@
+/**********************************
+ * FILE NAME: Message.h
+ *
+ * DESCRIPTION: Membership protocol messages.
+ * 				Message types, entry layouts and read-only views over received messages.
+ **********************************/
+
+#ifndef MESSAGE_H_
+#define MESSAGE_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+#include "EmulNet.h"
+#include "Wire.h"
+#include "MembershipDigest.h"
+
+/**
+ * Message Types
+ */
+enum MsgTypes{
+    JOINREQ,
+    JOINREP,
+	PING,
+	PONG,
+    TEST,
+    JOINFRAGREQ,
+    JOINREDIRECT,
+    FORWARDJOIN,
+    NEIGHBOR,
+    NEIGHBORREPLY,
+    DISCONNECT,
+    SHUFFLE,
+    SHUFFLEREPLY,
+    BROADCAST,
+    SYNCDIGEST,
+    SYNCENTRIES,
+    IHAVE,
+    GRAFT,
+    PRUNE,
+    LEAVE,
+    DUMMYLASTMSGTYPE
+};
+
+/**
+ * Member Status Types, in increasing precedence at equal incarnation
+ */
+typedef enum MemberStatus {
+    ALIVE,
+    SUSPECT,
+	DEAD,
+	LEFT,
+} MemberStatus;
+
+char memberStatus(MemberStatus m);
+
+/**
+ * STRUCT NAME: MemberInfo
+ *
+ * DESCRIPTION: Address, heartbeat and incarnation.
+ * 				Only the member itself raises its incarnation, to refute a
+ * 				suspicion about it.
+ */
+typedef struct MemberInfo {
+	int id;
+	short int port;
+	long heartbeat;
+	unsigned int incarnation;
+} MemberInfo;
+
+typedef struct MemberStatusInfo {
+	MemberStatus status;
+	MemberInfo info;
+} MemberStatusInfo;
+
+int compareStatus(const MemberStatusInfo *a, const MemberStatusInfo *b);
+
+/*
+ * Message layouts (see Wire.h for the encoding)
+ *
+ * JOINREQ: hdr, address, heartbeat, redirects
+ * JOINREP: hdr, address, snapshot, fragment, fragments, n, n x (id, port, incarnation, heartbeat delta)
+ * PING:    hdr, address, join load, n, n x (status, id, port, incarnation, heartbeat delta)
+ * PONG:    same as PING
+ * TEST:    hdr, address
+ * JOINFRAGREQ: hdr, address, snapshot, n, n x (first fragment, fragment count)
+ * JOINREDIRECT: hdr, address to send the JOINREQ to instead
+ * FORWARDJOIN, NEIGHBOR, NEIGHBORREPLY, DISCONNECT, SHUFFLE, SHUFFLEREPLY:
+ *          hdr, address, subject address, arg, n, n x address
+ * BROADCAST: hdr, address, origin address, sequence number, event status, subject address
+ * SYNCDIGEST: hdr, address, level, n, n x (bucket or leaf, hash)
+ * SYNCENTRIES: hdr, address, reply, n, n x leaf, n, n x (status, id, port, incarnation, heartbeat delta)
+ * IHAVE:   hdr, address, n, n x (origin address, sequence number)
+ * GRAFT:   hdr, address, origin address, sequence number
+ * PRUNE:   hdr, address
+ * LEAVE:   hdr, address, incarnation, heartbeat
+ *
+ * Heartbeats are zigzag encoded as the difference to the previous
+ * entry of the same message (the first one against 0).
+ *
+ * Statuses are ordered by (incarnation, status), see compareStatus: a
+ * suspected member refutes with ALIVE at a higher incarnation, which
+ * beats every SUSPECT of the lower one wherever it arrives.
+ *
+ * A membership snapshot larger than one message is split into JOINREP
+ * fragments of the same snapshot id. A joiner asks the sender for the
+ * fragment ranges it is still missing with JOINFRAGREQ.
+ *
+ * An overloaded introducer answers a JOINREQ with JOINREDIRECT. The
+ * joiner then retries at the given member with redirects incremented.
+ * The join load of a PING or PONG is the number of joiners its sender
+ * recently served in one tick, the introducer redirects to the least
+ * loaded member it heard of.
+ *
+ * The overlay messages maintain the partial views (see PartialView.h):
+ * FORWARDJOIN walks the joiner (subject) through the overlay for arg hops,
+ * NEIGHBOR asks to become an active neighbour (arg 1: high priority) and
+ * NEIGHBORREPLY answers it (arg 1: accepted). SHUFFLE walks arg hops on
+ * behalf of its origin (subject) and carries a sample of its views, which
+ * SHUFFLEREPLY answers with a sample of the passive view. BROADCAST floods
+ * a membership event about its subject (ALIVE: joined, DEAD: failed)
+ * over the active views.
+ *
+ * Anti-entropy compares membership digests (see MembershipDigest.h):
+ * SYNCDIGEST level 0 carries all bucket hashes, the answer at level 1 the
+ * leaf hashes of the differing buckets. SYNCENTRIES then carries the
+ * members of the differing leaves, removed ones as DEAD, and asks for the
+ * receiver's members of the same leaves in return if reply is set.
+ *
+ * With broadcast trees (Plumtree) a BROADCAST is only pushed to eager
+ * peers; lazy peers get IHAVE announcements of it. GRAFT pulls a missing
+ * BROADCAST and makes the link eager, PRUNE makes a redundant one lazy.
+ *
+ * A node shutting down sends LEAVE with its last heartbeat to its members
+ * (with partial views it floods a DEAD BROADCAST about itself instead).
+ * Receivers remove it at once and gossip it on as LEFT, which beats any
+ * entry of the same or an older incarnation.
+ */
+#define MEMBERINFO_WIRE_MAX (2 * WIRE_VARINT32_MAX + 3 + WIRE_VARINT64_MAX)
+// entries piggybacked on a PING or PONG: the sender itself and one gossiped entry
+#define PING_MAX_ENTRIES 2
+#define PING_WIRE_MAX (WIRE_HDR_SIZE + WIRE_ADDR_MAX + 2 + PING_MAX_ENTRIES * (1 + MEMBERINFO_WIRE_MAX))
+#define JOINREQ_WIRE_MAX (WIRE_HDR_SIZE + WIRE_ADDR_MAX + WIRE_VARINT64_MAX + 1)
+#define JOINREP_HDR_MAX (WIRE_HDR_SIZE + WIRE_ADDR_MAX + 4 * WIRE_VARINT32_MAX)
+// every fragment carries at least one of the at most MAX_NODES members
+#define JOINREP_MAX_FRAGMENTS MAX_NODES
+// fragment ranges carried by a single JOINFRAGREQ
+#define JOINFRAG_MAX_RANGES 64
+#define JOINFRAGREQ_WIRE_MAX (WIRE_HDR_SIZE + WIRE_ADDR_MAX + 2 * WIRE_VARINT32_MAX + JOINFRAG_MAX_RANGES * 2 * WIRE_VARINT32_MAX)
+// addresses carried by a single overlay message
+#define OVERLAY_MAX_ADDRS 16
+#define OVERLAY_WIRE_MAX (WIRE_HDR_SIZE + 2 * WIRE_ADDR_MAX + 2 * WIRE_VARINT32_MAX + OVERLAY_MAX_ADDRS * WIRE_ADDR_MAX)
+#define BROADCAST_WIRE_MAX (WIRE_HDR_SIZE + 3 * WIRE_ADDR_MAX + WIRE_VARINT32_MAX + 1)
+// BROADCASTs announced by a single IHAVE
+#define IHAVE_MAX_EVENTS 32
+#define IHAVE_WIRE_MAX (WIRE_HDR_SIZE + WIRE_ADDR_MAX + WIRE_VARINT32_MAX + IHAVE_MAX_EVENTS * (WIRE_ADDR_MAX + WIRE_VARINT32_MAX))
+#define GRAFT_WIRE_MAX (WIRE_HDR_SIZE + 2 * WIRE_ADDR_MAX + WIRE_VARINT32_MAX)
+#define LEAVE_WIRE_MAX (WIRE_HDR_SIZE + WIRE_ADDR_MAX + WIRE_VARINT32_MAX + WIRE_VARINT64_MAX)
+#define SYNCDIGEST_WIRE_MAX (WIRE_HDR_SIZE + WIRE_ADDR_MAX + 1 + WIRE_VARINT32_MAX + DIGEST_LEAVES * 2 * WIRE_VARINT32_MAX)
+
+/**
+ * STRUCT NAME: FragRange
+ *
+ * DESCRIPTION: Consecutive JOINREP fragments
+ */
+typedef struct FragRange {
+	unsigned int first;
+	unsigned int count;
+} FragRange;
+
+void putMemberInfo(WireWriter *w, MemberInfo *info, long *prev);
+void encodeJoinSnapshot(Address *from, vector<MemberListEntry> &list, unsigned int snapshot,
+		size_t maxSize, vector< vector<char> > *fragments);
+bool getMessageType(const char *data, int size, unsigned char *type);
+
+/**
+ * CLASS NAME: MemberListView
+ *
+ * DESCRIPTION: Read-only view over the member entries of a received message.
+ * 				parse() bounds-checks every entry once; iteration afterwards
+ * 				decodes straight from the receive buffer without copying it.
+ */
+class MemberListView {
+private:
+	const unsigned char *first;
+	const unsigned char *last;
+	size_t n;
+	bool withStatus;
+public:
+	/**
+	 * CLASS NAME: iterator
+	 *
+	 * DESCRIPTION: Forward iterator decoding one entry per step
+	 */
+	class iterator {
+	private:
+		const unsigned char *pos;
+		const unsigned char *next;
+		const unsigned char *last;
+		bool withStatus;
+		long prev;
+		MemberStatusInfo cur;
+		void decode();
+	public:
+		iterator(const unsigned char *pos, const unsigned char *last, bool withStatus);
+		const MemberStatusInfo &operator *() const { return cur; }
+		const MemberStatusInfo *operator ->() const { return &cur; }
+		iterator &operator ++();
+		bool operator !=(const iterator &other) const { return pos != other.pos; }
+	};
+	MemberListView(): first(NULL), last(NULL), n(0), withStatus(false) {}
+	bool parse(WireReader *r, bool withStatus);
+	size_t size() const { return n; }
+	iterator begin() const { return iterator(first, last, withStatus); }
+	iterator end() const { return iterator(last, last, withStatus); }
+};
+
+/**
+ * CLASS NAME: JoinReqView
+ *
+ * DESCRIPTION: Validated JOINREQ
+ */
+class JoinReqView {
+public:
+	Address addr;
+	long heartbeat;
+	unsigned char redirects;
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: JoinRepView
+ *
+ * DESCRIPTION: Validated JOINREP fragment
+ */
+class JoinRepView {
+public:
+	Address addr;
+	unsigned int snapshot;
+	unsigned int fragment;
+	unsigned int fragments;
+	MemberListView members;
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: JoinFragReqView
+ *
+ * DESCRIPTION: Validated JOINFRAGREQ
+ */
+class JoinFragReqView {
+public:
+	Address addr;
+	unsigned int snapshot;
+	size_t n;
+	FragRange ranges[JOINFRAG_MAX_RANGES];
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: PingView
+ *
+ * DESCRIPTION: Validated PING or PONG
+ */
+class PingView {
+public:
+	Address addr;
+	unsigned char joinLoad;
+	MemberListView members;
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: JoinRedirectView
+ *
+ * DESCRIPTION: Validated JOINREDIRECT
+ */
+class JoinRedirectView {
+public:
+	Address addr;
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: OverlayView
+ *
+ * DESCRIPTION: Validated FORWARDJOIN, NEIGHBOR, NEIGHBORREPLY, DISCONNECT, SHUFFLE or SHUFFLEREPLY
+ */
+class OverlayView {
+public:
+	Address addr;
+	Address subject;
+	unsigned int arg;
+	size_t n;
+	Address addrs[OVERLAY_MAX_ADDRS];
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: BroadcastView
+ *
+ * DESCRIPTION: Validated BROADCAST
+ */
+class BroadcastView {
+public:
+	Address addr;
+	Address origin;
+	unsigned int seq;
+	MemberStatus event;
+	Address subject;
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: SyncDigestView
+ *
+ * DESCRIPTION: Validated SYNCDIGEST
+ */
+class SyncDigestView {
+public:
+	Address addr;
+	unsigned char level;
+	size_t n;
+	unsigned short index[DIGEST_LEAVES];
+	unsigned int hash[DIGEST_LEAVES];
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: SyncEntriesView
+ *
+ * DESCRIPTION: Validated SYNCENTRIES
+ */
+class SyncEntriesView {
+public:
+	Address addr;
+	bool reply;
+	size_t n;
+	unsigned short leaves[DIGEST_LEAVES];
+	MemberListView members;
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: IHaveView
+ *
+ * DESCRIPTION: Validated IHAVE
+ */
+class IHaveView {
+public:
+	Address addr;
+	size_t n;
+	Address origins[IHAVE_MAX_EVENTS];
+	unsigned int seqs[IHAVE_MAX_EVENTS];
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: GraftView
+ *
+ * DESCRIPTION: Validated GRAFT
+ */
+class GraftView {
+public:
+	Address addr;
+	Address origin;
+	unsigned int seq;
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: PruneView
+ *
+ * DESCRIPTION: Validated PRUNE
+ */
+class PruneView {
+public:
+	Address addr;
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: LeaveView
+ *
+ * DESCRIPTION: Validated LEAVE
+ */
+class LeaveView {
+public:
+	Address addr;
+	unsigned int incarnation;
+	long heartbeat;
+	bool parse(const char *data, int size);
+};
+
+/**
+ * CLASS NAME: TestView
+ *
+ * DESCRIPTION: Validated TEST
+ */
+class TestView {
+public:
+	Address addr;
+	bool parse(const char *data, int size);
+};
+
+#endif /* MESSAGE_H_ */
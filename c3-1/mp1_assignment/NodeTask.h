@@ -0,0 +1,51 @@
+/**********************************
+ * FILE NAME: NodeTask.h
+ *
+ * DESCRIPTION: Coroutine type of the node protocol tasks
+ **********************************/
+
+#ifndef NODETASK_H_
+#define NODETASK_H_
+
+#include "stdincludes.h"
+
+#ifdef COROUTINES
+
+#include <coroutine>
+#include "FramePool.h"
+
+/**
+ * STRUCT NAME: NodeTask
+ *
+ * DESCRIPTION: A detached protocol task. It runs as soon as it is called,
+ * 				until its first suspension, and its frame, taken from the
+ * 				FramePool, is released when it returns. While suspended it
+ * 				is owned by whatever will resume it: the Scheduler or its node.
+ */
+struct NodeTask {
+	struct promise_type {
+		NodeTask get_return_object() {
+			return NodeTask();
+		}
+		std::suspend_never initial_suspend() noexcept {
+			return std::suspend_never();
+		}
+		std::suspend_never final_suspend() noexcept {
+			return std::suspend_never();
+		}
+		void return_void() {}
+		void unhandled_exception() {
+			terminate();
+		}
+		static void *operator new(size_t size) {
+			return FramePool::allocate(size);
+		}
+		static void operator delete(void *frame, size_t size) {
+			FramePool::release(frame, size);
+		}
+	};
+};
+
+#endif /* COROUTINES */
+
+#endif /* NODETASK_H_ */
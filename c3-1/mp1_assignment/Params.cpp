@@ -23,10 +23,20 @@ void Params::setparams(char *config_file) {
 	fscanf(fp,"\nSINGLE_FAILURE: %d", &SINGLE_FAILURE);
 	fscanf(fp,"\nDROP_MSG: %d", &DROP_MSG);
 	fscanf(fp,"\nMSG_DROP_PROB: %lf", &MSG_DROP_PROB);
+	// optional
+	INTRODUCERS = 1;
+	fscanf(fp,"\nINTRODUCERS: %d", &INTRODUCERS);
+	PARTIAL_VIEW = 0;
+	fscanf(fp,"\nPARTIAL_VIEW: %d", &PARTIAL_VIEW);
+	GRACEFUL_LEAVE = 0;
+	fscanf(fp,"\nGRACEFUL_LEAVE: %d", &GRACEFUL_LEAVE);
+	LOG_LEVEL = 2;
+	fscanf(fp,"\nLOG_LEVEL: %d", &LOG_LEVEL);
 
 	//printf("Parameters of the test case: %d %d %d %lf\n", MAX_NNB, SINGLE_FAILURE, DROP_MSG, MSG_DROP_PROB);
 
 	EN_GPSZ = MAX_NNB;
+	INTRODUCERS = max(1, min(INTRODUCERS, EN_GPSZ));
 	STEP_RATE=.25;
 	MAX_MSG_SIZE = 4000;
 	globaltime = 0;
@@ -48,3 +58,13 @@ void Params::setparams(char *config_file) {
 int Params::getcurrtime(){
     return globaltime;
 }
+
+/**
+ * FUNCTION NAME: getIntroducer
+ *
+ * DESCRIPTION: Address of the i-th introducer, 0 <= i < INTRODUCERS.
+ * 				The first one boots the group.
+ */
+Address Params::getIntroducer(int i) {
+	return Address(i + 1, 0);
+}
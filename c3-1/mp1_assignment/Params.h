@@ -26,6 +26,10 @@ public:
 	double STEP_RATE;		    // dictates the rate of insertion
 	int EN_GPSZ;			    // actual number of peers
 	int MAX_MSG_SIZE;
+	int INTRODUCERS;			// number of introducers, nodes 1..INTRODUCERS
+	int PARTIAL_VIEW;			// 1: HyParView partial views instead of the full membership list
+	int GRACEFUL_LEAVE;			// 1: the failing nodes leave the group gracefully instead of crashing
+	int LOG_LEVEL;				// dbg.log detail: 0 errors, 1 info, 2 trace (see LogLevel in Log.h)
 	int DROP_MSG;
 	int dropmsg;
 	int globaltime;
@@ -34,6 +38,7 @@ public:
 	Params();
 	void setparams(char *);
 	int getcurrtime();
+	Address getIntroducer(int i);
 };
 
 #endif /* _PARAMS_H_ */
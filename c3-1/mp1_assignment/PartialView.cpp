@@ -0,0 +1,120 @@
+/**********************************
+ * FILE NAME: PartialView.cpp
+ *
+ * DESCRIPTION: Definition of PartialView class
+ **********************************/
+
+#include "PartialView.h"
+
+/**
+ * FUNCTION NAME: init
+ *
+ * DESCRIPTION: Size the views for a group of groupSize nodes
+ */
+void PartialView::init(int groupSize) {
+	activeMax = (size_t)ceil(::log((double)max(groupSize, 2))) + 1;
+	passiveMax = PASSIVE_VIEW_FACTOR * activeMax;
+	passive.clear();
+	passive.reserve(passiveMax);
+}
+
+/**
+ * FUNCTION NAME: getActiveMax
+ *
+ * DESCRIPTION: Number of active neighbours to keep
+ */
+size_t PartialView::getActiveMax() {
+	return activeMax;
+}
+
+/**
+ * FUNCTION NAME: addPassive
+ *
+ * DESCRIPTION: Add a node to the passive view, evicting a random one when it is full
+ */
+void PartialView::addPassive(Address *addr) {
+	if (inPassive(addr) || passiveMax == 0) {
+		return;
+	}
+	if (passive.size() >= passiveMax) {
+		passive[rand() % passive.size()] = *addr;
+		return;
+	}
+	passive.push_back(*addr);
+}
+
+/**
+ * FUNCTION NAME: removePassive
+ *
+ * DESCRIPTION: Drop a node from the passive view
+ *
+ * RETURNS:
+ * false if it was not there
+ */
+bool PartialView::removePassive(Address *addr) {
+	for (size_t i = 0; i < passive.size(); ++i) {
+		if (passive[i] == *addr) {
+			passive[i] = passive.back();
+			passive.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * FUNCTION NAME: inPassive
+ *
+ * DESCRIPTION: true if the node is in the passive view
+ */
+bool PartialView::inPassive(Address *addr) {
+	return find(passive.begin(), passive.end(), *addr) != passive.end();
+}
+
+/**
+ * FUNCTION NAME: randomPassive
+ *
+ * DESCRIPTION: Pick a random passive view member
+ *
+ * RETURNS:
+ * false if the passive view is empty
+ */
+bool PartialView::randomPassive(Address *addr) {
+	if (passive.empty()) {
+		return false;
+	}
+	*addr = passive[rand() % passive.size()];
+	return true;
+}
+
+/**
+ * FUNCTION NAME: samplePassive
+ *
+ * DESCRIPTION: Append up to k distinct random passive view members to out
+ */
+void PartialView::samplePassive(size_t k, vector<Address> *out) {
+	// partial Fisher-Yates over the passive view, which is unordered anyway
+	for (size_t i = 0; i < k && i < passive.size(); ++i) {
+		size_t j = i + rand() % (passive.size() - i);
+		swap(passive[i], passive[j]);
+		out->push_back(passive[i]);
+	}
+}
+
+/**
+ * FUNCTION NAME: passiveSize
+ *
+ * DESCRIPTION: Number of passive view members
+ */
+size_t PartialView::passiveSize() {
+	return passive.size();
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Forget the passive view
+ */
+void PartialView::clear() {
+	passive.clear();
+}
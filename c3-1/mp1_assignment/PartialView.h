@@ -0,0 +1,56 @@
+/**********************************
+ * FILE NAME: PartialView.h
+ *
+ * DESCRIPTION: Header file of PartialView class
+ **********************************/
+
+#ifndef PARTIALVIEW_H_
+#define PARTIALVIEW_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+
+/*
+ * Macros
+ */
+// passive view size relative to the active view size
+#define PASSIVE_VIEW_FACTOR 6
+// hops of the FORWARDJOIN random walk, and the hop that adds the joiner to the passive view
+#define ACTIVE_RWL 6
+#define PASSIVE_RWL 3
+// ticks between SHUFFLEs, and hops of their random walk
+#define SHUFFLE_PERIOD 10
+#define SHUFFLE_RWL 4
+// active and passive view members sent with a SHUFFLE, besides the origin itself
+#define SHUFFLE_ACTIVE 3
+#define SHUFFLE_PASSIVE 4
+
+/**
+ * CLASS NAME: PartialView
+ *
+ * DESCRIPTION: View sizes and passive view of the HyParView partial membership.
+ * 				The active view is the membership list itself; it holds ln(N) + 1
+ * 				symmetric neighbours. The passive view is a PASSIVE_VIEW_FACTOR times
+ * 				larger random sample of the group, refreshed by SHUFFLEs, from which
+ * 				failed or disconnected active neighbours are replaced.
+ */
+class PartialView {
+private:
+	size_t activeMax;
+	size_t passiveMax;
+	vector<Address> passive;
+public:
+	PartialView(): activeMax(0), passiveMax(0) {}
+	virtual ~PartialView() {}
+	void init(int groupSize);
+	size_t getActiveMax();
+	void addPassive(Address *addr);
+	bool removePassive(Address *addr);
+	bool inPassive(Address *addr);
+	bool randomPassive(Address *addr);
+	void samplePassive(size_t k, vector<Address> *out);
+	size_t passiveSize();
+	void clear();
+};
+
+#endif /* PARTIALVIEW_H_ */
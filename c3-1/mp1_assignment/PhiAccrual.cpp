@@ -0,0 +1,54 @@
+/**********************************
+ * FILE NAME: PhiAccrual.cpp
+ *
+ * DESCRIPTION: Definition of PhiAccrual class
+ **********************************/
+
+#include "PhiAccrual.h"
+
+/**
+ * FUNCTION NAME: heartbeat
+ *
+ * DESCRIPTION: Record a heartbeat arriving at time now
+ */
+void PhiAccrual::heartbeat(int now) {
+	if (last >= 0) {
+		int interval = min(now - last, 0xffff);
+		if (count == PHI_WINDOW) {
+			sum -= intervals[head];
+			sumSq -= (long long)intervals[head] * intervals[head];
+		} else {
+			count++;
+		}
+		intervals[head] = interval;
+		sum += interval;
+		sumSq += (long long)interval * interval;
+		head = (head + 1) % PHI_WINDOW;
+	}
+	last = now;
+}
+
+/**
+ * FUNCTION NAME: phi
+ *
+ * DESCRIPTION: Suspicion level at time now, -log10 of the probability that a heartbeat
+ * 				still arrives this late. Uses the logistic approximation of the normal CDF.
+ *
+ * RETURNS:
+ * 0 until an interval has been observed
+ */
+double PhiAccrual::phi(int now) {
+	if (count == 0) {
+		return 0.0;
+	}
+	double mean = (double)sum / count;
+	double variance = (double)sumSq / count - mean * mean;
+	double stddev = max(PHI_MIN_STDDEV, sqrt(max(0.0, variance)));
+	double y = (now - last - mean) / stddev;
+	double e = exp(-y * (1.5976 + 0.070566 * y * y));
+	double p = (y > 0) ? e / (1.0 + e) : 1.0 - 1.0 / (1.0 + e);
+	if (p <= 0.0) {
+		return 1e9;
+	}
+	return -log10(p);
+}
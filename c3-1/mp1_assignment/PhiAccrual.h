@@ -0,0 +1,43 @@
+/**********************************
+ * FILE NAME: PhiAccrual.h
+ *
+ * DESCRIPTION: Header file of PhiAccrual class
+ **********************************/
+
+#ifndef PHIACCRUAL_H_
+#define PHIACCRUAL_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// heartbeat inter-arrival times kept per member
+#define PHI_WINDOW 8
+// lower bound of the standard deviation, in ticks
+#define PHI_MIN_STDDEV 1.0
+
+/**
+ * CLASS NAME: PhiAccrual
+ *
+ * DESCRIPTION: Phi-accrual failure detector state of a single member.
+ * 				A ring of the last PHI_WINDOW heartbeat inter-arrival times
+ * 				with running sums, so a heartbeat is O(1) and phi needs no
+ * 				pass over the ring.
+ */
+class PhiAccrual {
+private:
+	unsigned short intervals[PHI_WINDOW];
+	unsigned char head;
+	unsigned char count;
+	int last;
+	// 64 bit: PHI_WINDOW squares of intervals up to 0xffff overflow an int
+	long long sum;
+	long long sumSq;
+public:
+	PhiAccrual(): head(0), count(0), last(-1), sum(0), sumSq(0) {}
+	void heartbeat(int now);
+	double phi(int now);
+};
+
+#endif /* PHIACCRUAL_H_ */
@@ -0,0 +1,89 @@
+/**********************************
+ * FILE NAME: ProbeScheduler.cpp
+ *
+ * DESCRIPTION: Definition of ProbeScheduler class
+ **********************************/
+
+#include "ProbeScheduler.h"
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Insert a new member at a uniformly random position of the probe order.
+ * 				Members inserted before the cursor are first probed in the next round.
+ */
+void ProbeScheduler::add(Address *addr) {
+	size_t pos = rand() % (order.size() + 1);
+	order.insert(order.begin() + pos, *addr);
+	if (pos < next) {
+		next++;
+	}
+}
+
+/**
+ * FUNCTION NAME: remove
+ *
+ * DESCRIPTION: Drop a member from the probe order, keeping the cursor on the same target
+ */
+void ProbeScheduler::remove(Address *addr) {
+	for (size_t i = 0; i < order.size(); ++i) {
+		if (order[i] == *addr) {
+			order.erase(order.begin() + i);
+			if (i < next) {
+				next--;
+			}
+			return;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: nextTarget
+ *
+ * DESCRIPTION: Returns the next member to probe, reshuffling when a round is complete
+ *
+ * RETURNS:
+ * false if there is nobody to probe
+ */
+bool ProbeScheduler::nextTarget(Address *target) {
+	if (order.empty()) {
+		return false;
+	}
+	if (next >= order.size()) {
+		shuffle();
+		next = 0;
+	}
+	*target = order[next++];
+	return true;
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Number of members in the probe order
+ */
+size_t ProbeScheduler::size() {
+	return order.size();
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Forget all members
+ */
+void ProbeScheduler::clear() {
+	order.clear();
+	next = 0;
+}
+
+/**
+ * FUNCTION NAME: shuffle
+ *
+ * DESCRIPTION: Fisher-Yates shuffle of the probe order
+ */
+void ProbeScheduler::shuffle() {
+	for (size_t i = order.size() - 1; i > 0; --i) {
+		size_t j = rand() % (i + 1);
+		swap(order[i], order[j]);
+	}
+}
@@ -0,0 +1,38 @@
+/**********************************
+ * FILE NAME: ProbeScheduler.h
+ *
+ * DESCRIPTION: Header file of ProbeScheduler class
+ **********************************/
+
+#ifndef PROBESCHEDULER_H_
+#define PROBESCHEDULER_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+
+/**
+ * CLASS NAME: ProbeScheduler
+ *
+ * DESCRIPTION: Round-robin probe target selection over a random permutation
+ * 				of the membership. The permutation is reshuffled at the start of
+ * 				every round and new members are inserted at a random position, so
+ * 				every member is probed within 2N protocol periods.
+ */
+class ProbeScheduler {
+private:
+	// Probe order of the current round
+	vector<Address> order;
+	// Index of the next target in order
+	size_t next;
+	void shuffle();
+public:
+	ProbeScheduler(): next(0) {}
+	virtual ~ProbeScheduler() {}
+	void add(Address *addr);
+	void remove(Address *addr);
+	bool nextTarget(Address *target);
+	size_t size();
+	void clear();
+};
+
+#endif /* PROBESCHEDULER_H_ */
@@ -1,7 +1,7 @@
 /**********************************
  * FILE NAME: Queue.h
  *
- * DESCRIPTION: Header file for std::<queue> related functions
+ * DESCRIPTION: Header file for node inbox related functions
  **********************************/
 
 #ifndef QUEUE_H_
@@ -13,15 +13,19 @@
 /**
  * Class name: Queue
  *
- * Description: This function wraps std::queue related functions
+ * Description: This function wraps Inbox related functions
  */
 class Queue {
 public:
 	Queue() {}
 	virtual ~Queue() {}
-	static bool enqueue(queue<q_elt> *queue, void *buffer, int size) {
-		q_elt element(buffer, size);
-		queue->emplace(element);
+	// copies the buffer, which stays owned by the caller
+	static bool enqueue(Inbox *inbox, void *buffer, int size) {
+		InboxMsg *msg = InboxMsg::create((char *)buffer, size);
+		if (!inbox->push(msg)) {
+			InboxMsg::destroy(msg);
+			return false;
+		}
 		return true;
 	}
 };
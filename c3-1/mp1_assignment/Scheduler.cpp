@@ -0,0 +1,124 @@
+/**********************************
+ * FILE NAME: Scheduler.cpp
+ *
+ * DESCRIPTION: Definition of Scheduler class
+ **********************************/
+
+#include "Scheduler.h"
+
+#ifdef COROUTINES
+
+/**
+ * Destructor, destroys the coroutines still waiting
+ */
+Scheduler::~Scheduler() {
+	for (size_t i = 0; i < ready.size(); ++i) {
+		ready[i].destroy();
+	}
+	for (int b = 0; b < TIMER_WHEEL_SIZE; ++b) {
+		for (size_t i = 0; i < wheel[b].size(); ++i) {
+			wheel[b][i].handle.destroy();
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: getNow
+ *
+ * DESCRIPTION: Tick being run
+ */
+int Scheduler::getNow() {
+	return now;
+}
+
+/**
+ * FUNCTION NAME: wake
+ *
+ * DESCRIPTION: Queue a coroutine whose event happened, it is resumed by this or the next run
+ */
+void Scheduler::wake(std::coroutine_handle<> handle) {
+	ready.push_back(handle);
+}
+
+/**
+ * FUNCTION NAME: addTimer
+ *
+ * DESCRIPTION: Resume a coroutine ticks ticks from now
+ *
+ * RETURNS:
+ * the deadline, to cancel the timer with
+ */
+int Scheduler::addTimer(int ticks, std::coroutine_handle<> handle) {
+	assert(ticks > 0 && ticks < TIMER_WHEEL_SIZE);
+	TimerEntry entry;
+	entry.deadline = now + ticks;
+	entry.handle = handle;
+	wheel[entry.deadline & (TIMER_WHEEL_SIZE - 1)].push_back(entry);
+	return entry.deadline;
+}
+
+/**
+ * FUNCTION NAME: cancelTimer
+ *
+ * DESCRIPTION: Forget the timer of a coroutine that was resumed by another event
+ */
+void Scheduler::cancelTimer(int deadline, std::coroutine_handle<> handle) {
+	vector<TimerEntry> &bucket = wheel[deadline & (TIMER_WHEEL_SIZE - 1)];
+	for (size_t i = 0; i < bucket.size(); ++i) {
+		if (bucket[i].handle == handle) {
+			bucket.erase(bucket.begin() + i);
+			return;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: drainReady
+ *
+ * DESCRIPTION: Resume the ready queue, including coroutines woken meanwhile
+ */
+void Scheduler::drainReady() {
+	for (size_t i = 0; i < ready.size(); ++i) {
+		resumes++;
+		ready[i].resume();
+	}
+	ready.clear();
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Run a tick: the woken coroutines, then the timers due, in the order they were set
+ */
+void Scheduler::run(int now) {
+	this->now = now;
+	drainReady();
+
+	vector<TimerEntry> &bucket = wheel[now & (TIMER_WHEEL_SIZE - 1)];
+	due.clear();
+	size_t keep = 0;
+	for (size_t i = 0; i < bucket.size(); ++i) {
+		if (bucket[i].deadline == now) {
+			due.push_back(bucket[i]);
+		} else {
+			bucket[keep++] = bucket[i];
+		}
+	}
+	bucket.resize(keep);
+	for (size_t i = 0; i < due.size(); ++i) {
+		resumes++;
+		due[i].handle.resume();
+	}
+	drainReady();
+}
+
+/**
+ * FUNCTION NAME: getResumes
+ *
+ * DESCRIPTION: Number of coroutine resumptions so far
+ */
+long Scheduler::getResumes() {
+	return resumes;
+}
+
+#endif /* COROUTINES */
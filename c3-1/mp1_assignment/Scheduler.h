@@ -0,0 +1,80 @@
+/**********************************
+ * FILE NAME: Scheduler.h
+ *
+ * DESCRIPTION: Header file of Scheduler class
+ **********************************/
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include "stdincludes.h"
+
+#ifdef COROUTINES
+
+#include <coroutine>
+
+/*
+ * Macros
+ */
+// buckets of the timer wheel, a power of 2 above the longest timer
+#define TIMER_WHEEL_SIZE 64
+
+/**
+ * STRUCT NAME: TimerEntry
+ *
+ * DESCRIPTION: A coroutine waiting for a tick
+ */
+typedef struct TimerEntry {
+	int deadline;
+	std::coroutine_handle<> handle;
+} TimerEntry;
+
+/**
+ * CLASS NAME: Scheduler
+ *
+ * DESCRIPTION: Resumes node coroutines whose awaited event is ready.
+ * 				Coroutines woken by an event go on the ready queue, timers
+ * 				sit in a wheel bucket until their tick, so a waiting
+ * 				coroutine costs nothing until then. run() resumes the
+ * 				ready queue first, then the timers due this tick.
+ */
+class Scheduler {
+private:
+	int now;
+	vector<std::coroutine_handle<>> ready;
+	vector<TimerEntry> wheel[TIMER_WHEEL_SIZE];
+	vector<TimerEntry> due;
+	long resumes;
+	void drainReady();
+public:
+	Scheduler(): now(0), resumes(0) {}
+	virtual ~Scheduler();
+	int getNow();
+	void wake(std::coroutine_handle<> handle);
+	int addTimer(int ticks, std::coroutine_handle<> handle);
+	void cancelTimer(int deadline, std::coroutine_handle<> handle);
+	void run(int now);
+	long getResumes();
+};
+
+/**
+ * STRUCT NAME: TimerAwait
+ *
+ * DESCRIPTION: co_await TimerAwait(sched, ticks) resumes ticks ticks later
+ */
+struct TimerAwait {
+	Scheduler *sched;
+	int ticks;
+	TimerAwait(Scheduler *sched, int ticks): sched(sched), ticks(ticks) {}
+	bool await_ready() {
+		return false;
+	}
+	void await_suspend(std::coroutine_handle<> handle) {
+		sched->addTimer(ticks, handle);
+	}
+	void await_resume() {}
+};
+
+#endif /* COROUTINES */
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,52 @@
+/**********************************
+ * FILE NAME: SendBudget.cpp
+ *
+ * DESCRIPTION: Definition of SendBudget class
+ **********************************/
+
+#include "SendBudget.h"
+
+/**
+ * FUNCTION NAME: refill
+ *
+ * DESCRIPTION: Add the tokens of the ticks since the last send
+ */
+void SendBudget::refill(int now) {
+	if (now > lastTick) {
+		tokens = min((long)SEND_BURST, tokens + (long)SEND_RATE * (now - lastTick));
+		lastTick = now;
+	}
+}
+
+/**
+ * FUNCTION NAME: take
+ *
+ * DESCRIPTION: Charge a message of the given class to the bucket if it may go now
+ *
+ * RETURNS:
+ * true if the message may be sent
+ */
+bool SendBudget::take(enum SendClass cls, size_t bytes, int now) {
+	refill(now);
+	long need = 0;
+	if (cls == SEND_UPDATE) {
+		need = (long)bytes;
+	} else if (cls == SEND_BULK) {
+		need = (long)bytes + SEND_BULK_RESERVE;
+	}
+	if (tokens < need) {
+		return false;
+	}
+	// the debt of a probe burst is bounded, so lower classes resume within a few ticks
+	tokens = max(-(long)SEND_BURST, tokens - (long)bytes);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: getTokens
+ *
+ * DESCRIPTION: Bytes left in the bucket, negative while in debt
+ */
+long SendBudget::getTokens() {
+	return tokens;
+}
@@ -0,0 +1,56 @@
+/**********************************
+ * FILE NAME: SendBudget.h
+ *
+ * DESCRIPTION: Header file of SendBudget class
+ **********************************/
+
+#ifndef SENDBUDGET_H_
+#define SENDBUDGET_H_
+
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// bytes a node may send per tick, and the burst it may save up
+#define SEND_RATE 3000
+#define SEND_BURST 12000
+// bytes bulk sends must leave in the bucket for probes and updates
+#define SEND_BULK_RESERVE 3000
+
+/**
+ * ENUM NAME: SendClass
+ *
+ * DESCRIPTION: Priority of an outgoing message, highest first
+ */
+enum SendClass {
+	// PING and PONG, liveness depends on them: always sent
+	SEND_PROBE,
+	// membership changes and overlay maintenance: deferred when over budget
+	SEND_UPDATE,
+	// JOINREP snapshots and anti-entropy: trimmed when over budget, both are repaired
+	SEND_BULK
+};
+
+/**
+ * CLASS NAME: SendBudget
+ *
+ * DESCRIPTION: Token bucket of a node's outgoing bytes. It fills by SEND_RATE
+ * 				per tick up to SEND_BURST. Probes always pass and may take the
+ * 				bucket into debt, which lower classes then wait out. Updates
+ * 				pass while the bucket covers them, bulk sends only while
+ * 				SEND_BULK_RESERVE is left after them.
+ */
+class SendBudget {
+private:
+	long tokens;
+	int lastTick;
+	void refill(int now);
+public:
+	SendBudget(): tokens(SEND_BURST), lastTick(0) {}
+	virtual ~SendBudget() {}
+	bool take(enum SendClass cls, size_t bytes, int now);
+	long getTokens();
+};
+
+#endif /* SENDBUDGET_H_ */
@@ -0,0 +1,180 @@
+/**********************************
+ * FILE NAME: Wire.cpp
+ *
+ * DESCRIPTION: Definition of the wire encoding classes
+ **********************************/
+
+#include "Wire.h"
+
+/**
+ * Constructor
+ */
+WireWriter::WireWriter(char *buf, size_t cap): buf((unsigned char *)buf), cap(cap), pos(0), overflow(false) {}
+
+/**
+ * FUNCTION NAME: putHeader
+ *
+ * DESCRIPTION: Write the format version and the message type
+ */
+void WireWriter::putHeader(unsigned char type) {
+	putByte(WIRE_VERSION);
+	putByte(type);
+}
+
+/**
+ * FUNCTION NAME: putByte
+ *
+ * DESCRIPTION: Write a single byte
+ */
+void WireWriter::putByte(unsigned char b) {
+	if (pos >= cap) {
+		overflow = true;
+		return;
+	}
+	buf[pos++] = b;
+}
+
+/**
+ * FUNCTION NAME: putVarint
+ *
+ * DESCRIPTION: Write an unsigned LEB128 varint
+ */
+void WireWriter::putVarint(unsigned long long v) {
+	while (v >= 0x80) {
+		putByte((unsigned char)(v | 0x80));
+		v >>= 7;
+	}
+	putByte((unsigned char)v);
+}
+
+/**
+ * FUNCTION NAME: putZigzag
+ *
+ * DESCRIPTION: Write a signed value so that small magnitudes stay short
+ */
+void WireWriter::putZigzag(long long v) {
+	putVarint(((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63));
+}
+
+/**
+ * FUNCTION NAME: putAddress
+ *
+ * DESCRIPTION: Write an address as id and port varints
+ */
+void WireWriter::putAddress(Address *addr) {
+	putVarint((unsigned int)addr->getId());
+	putVarint((unsigned short)addr->getPort());
+}
+
+/**
+ * FUNCTION NAME: size
+ *
+ * DESCRIPTION: Number of bytes written
+ */
+size_t WireWriter::size() {
+	return pos;
+}
+
+/**
+ * FUNCTION NAME: ok
+ *
+ * DESCRIPTION: false if any write did not fit into the buffer
+ */
+bool WireWriter::ok() {
+	return !overflow;
+}
+
+/**
+ * Constructor
+ */
+WireReader::WireReader(const char *buf, size_t len): buf((const unsigned char *)buf), len(len), pos(0) {}
+
+/**
+ * FUNCTION NAME: getHeader
+ *
+ * DESCRIPTION: Read the message type, rejecting unknown format versions
+ */
+bool WireReader::getHeader(unsigned char *type) {
+	unsigned char version;
+	return getByte(&version) && version == WIRE_VERSION && getByte(type);
+}
+
+/**
+ * FUNCTION NAME: getByte
+ *
+ * DESCRIPTION: Read a single byte
+ */
+bool WireReader::getByte(unsigned char *b) {
+	if (pos >= len) {
+		return false;
+	}
+	*b = buf[pos++];
+	return true;
+}
+
+/**
+ * FUNCTION NAME: getVarint
+ *
+ * DESCRIPTION: Read an unsigned LEB128 varint
+ */
+bool WireReader::getVarint(unsigned long long *v) {
+	unsigned long long result = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		unsigned char b;
+		if (!getByte(&b)) {
+			return false;
+		}
+		result |= (unsigned long long)(b & 0x7f) << shift;
+		if (!(b & 0x80)) {
+			*v = result;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * FUNCTION NAME: getZigzag
+ *
+ * DESCRIPTION: Read a zigzag encoded signed value
+ */
+bool WireReader::getZigzag(long long *v) {
+	unsigned long long u;
+	if (!getVarint(&u)) {
+		return false;
+	}
+	*v = (long long)(u >> 1) ^ -(long long)(u & 1);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: getAddress
+ *
+ * DESCRIPTION: Read an address written by putAddress
+ */
+bool WireReader::getAddress(Address *addr) {
+	unsigned long long id, port;
+	if (!getVarint(&id) || id > 0xffffffffULL || !getVarint(&port) || port > 0xffffULL) {
+		return false;
+	}
+	*addr = Address((int)id, (short)port);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: remaining
+ *
+ * DESCRIPTION: Number of bytes not read yet
+ */
+size_t WireReader::remaining() {
+	return len - pos;
+}
+
+/**
+ * FUNCTION NAME: cursor
+ *
+ * DESCRIPTION: Pointer to the next byte to be read
+ */
+const char *WireReader::cursor() {
+	return (const char *)(buf + pos);
+}
@@ -0,0 +1,75 @@
+/**********************************
+ * FILE NAME: Wire.h
+ *
+ * DESCRIPTION: Header file of the wire encoding classes
+ *
+ * 				Every message starts with a 1-byte format version and a
+ * 				1-byte message type. Integers are LEB128 varints (least
+ * 				significant group first, so byte order is fixed regardless
+ * 				of the host), signed values are zigzag encoded first.
+ **********************************/
+
+#ifndef WIRE_H_
+#define WIRE_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+
+/*
+ * Macros
+ */
+// 2: member entries carry an incarnation
+#define WIRE_VERSION 2
+// version + type
+#define WIRE_HDR_SIZE 2
+// worst case encoded sizes
+#define WIRE_VARINT32_MAX 5
+#define WIRE_VARINT64_MAX 10
+#define WIRE_ADDR_MAX (WIRE_VARINT32_MAX + 3)
+
+/**
+ * CLASS NAME: WireWriter
+ *
+ * DESCRIPTION: Appends encoded values to a caller owned buffer.
+ * 				Writes past the capacity are dropped and flagged.
+ */
+class WireWriter {
+private:
+	unsigned char *buf;
+	size_t cap;
+	size_t pos;
+	bool overflow;
+public:
+	WireWriter(char *buf, size_t cap);
+	void putHeader(unsigned char type);
+	void putByte(unsigned char b);
+	void putVarint(unsigned long long v);
+	void putZigzag(long long v);
+	void putAddress(Address *addr);
+	size_t size();
+	bool ok();
+};
+
+/**
+ * CLASS NAME: WireReader
+ *
+ * DESCRIPTION: Decodes values from a received buffer.
+ * 				Every getter fails instead of reading past the end.
+ */
+class WireReader {
+private:
+	const unsigned char *buf;
+	size_t len;
+	size_t pos;
+public:
+	WireReader(const char *buf, size_t len);
+	bool getHeader(unsigned char *type);
+	bool getByte(unsigned char *b);
+	bool getVarint(unsigned long long *v);
+	bool getZigzag(long long *v);
+	bool getAddress(Address *addr);
+	size_t remaining();
+	const char *cursor();
+};
+
+#endif /* WIRE_H_ */
@@ -25,16 +25,26 @@
 #include <time.h>
 #include <stdarg.h>
 #include <unistd.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <execinfo.h>
 #include <signal.h>
 #include <iostream>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <algorithm>
 #include <queue>
 #include <fstream>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <new>
+#include <type_traits>
 
 using namespace std;
 